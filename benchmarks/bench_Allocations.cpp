@@ -0,0 +1,207 @@
+/**
+ * Counts heap allocations per operation in ThreadManager's steady state, i.e.
+ * after set_thread_cache() and reserve(), by replacing the global operator
+ * new. Exits with failure when a scenario allocates more than its budget, so
+ * it doubles as a regression test.
+ *
+ * Usage: ParallelLauncher_bench_allocations [<rounds>] [<threads per round>]
+ */
+
+#include <ThreadManager.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <stop_token>
+#include <thread>
+
+namespace
+{
+  std::atomic<uint64_t> allocations{0};
+
+  void* counted_alloc(size_t size, size_t alignment)
+  {
+    allocations.fetch_add(1, std::memory_order::relaxed);
+    void* ptr = nullptr;
+    if (alignment > alignof(std::max_align_t))
+    {
+      // aligned_alloc needs a size that is a multiple of the alignment
+      size = (size + alignment - 1) / alignment * alignment;
+      ptr = std::aligned_alloc(alignment, size == 0 ? alignment : size);
+    }
+    else
+    {
+      ptr = std::malloc(size == 0 ? 1 : size);
+    }
+    return ptr;
+  }
+
+  // Kept out of line: inlining free() into operator delete trips GCC's
+  // mismatched new/delete warning on every replaced operator
+  [[gnu::noinline]] void counted_free(void* ptr) noexcept
+  {
+    std::free(ptr);
+  }
+
+  struct Scenario_t
+  {
+    const char* name;
+    // Allowed allocations per operation
+    double budget;
+    // Whether every spawned thread is also stopped through request_stop()
+    bool stop_each;
+    // Whether the worker takes its local token as a std::stop_token rather
+    // than a CancellationToken
+    bool stop_token;
+  };
+}
+
+void* operator new(size_t size)
+{
+  if (void* ptr = counted_alloc(size, alignof(std::max_align_t)))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+  return ::operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+  if (void* ptr = counted_alloc(size, static_cast<size_t>(alignment)))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+  return ::operator new(size, alignment);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  return counted_alloc(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+  return counted_alloc(size, alignof(std::max_align_t));
+}
+
+void operator delete(void* ptr) noexcept
+{
+  counted_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  counted_free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+  counted_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+  counted_free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+  counted_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+  counted_free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+  counted_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept
+{
+  counted_free(ptr);
+}
+
+int main(int argc, char** argv)
+{
+  uint64_t rounds = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200ULL;
+  unsigned threads = argc > 2
+    ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+    : 8U;
+
+  // Local CancellationSources are re-armed after join, while a stopped
+  // std::stop_source state can not be, hence costs a new one per thread
+  const Scenario_t scenarios[] = {
+    {"spawn + join", 0.0, false, false},
+    {"spawn + request_stop + join", 0.0, true, false},
+    {"spawn + request_stop + join (std::stop_token)", 1.0, true, true},
+  };
+
+  bool within_budget = true;
+  std::printf("%-46s %14s %8s\n", "operation", "allocs/op", "budget");
+
+  for (const Scenario_t& scenario : scenarios)
+  {
+    ThreadManager tm;
+    tm.set_thread_cache(threads, std::chrono::seconds(60));
+    tm.reserve(threads);
+
+    auto round = [&] {
+      for (unsigned t = 0; t < threads; t++)
+      {
+        std::thread::id tid = scenario.stop_token
+          ? tm.spawn_thread(
+              [](std::stop_token, CancellationToken, uint64_t) { },
+              uint64_t{t}
+            )
+          : tm.spawn_thread(
+              [](CancellationToken, CancellationToken, uint64_t) { },
+              uint64_t{t}
+            );
+        if (scenario.stop_each)
+        {
+          tm.request_stop(tid);
+        }
+      }
+      tm.join();
+    };
+
+    // Lets lazily initialised runtime state (thread locals, rseq) settle
+    round();
+
+    uint64_t before = allocations.load(std::memory_order::relaxed);
+    for (uint64_t r = 0; r < rounds; r++)
+    {
+      round();
+    }
+    uint64_t total = allocations.load(std::memory_order::relaxed) - before;
+
+    double per_op = static_cast<double>(total) /
+                    static_cast<double>(rounds * threads);
+    within_budget = within_budget && per_op <= scenario.budget;
+    std::printf("%-46s %14.3f %8.3f\n", scenario.name, per_op, scenario.budget);
+  }
+
+  if (!within_budget)
+  {
+    std::fprintf(stderr, "allocation budget exceeded\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
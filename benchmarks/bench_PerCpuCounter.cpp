@@ -0,0 +1,95 @@
+/**
+ * Compares a single seq_cst std::atomic counter against PerCpuCounter when
+ * many threads increment and decrement it concurrently, the access pattern of
+ * ThreadManager's thread counter.
+ *
+ * Usage: ParallelLauncher_bench_counter [<ops per thread>] [<max threads>]
+ */
+
+#include <PerCpuCounter.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  // Runs `body` on `nthreads` threads released together, returns ns per op
+  template <typename Body>
+  double run(unsigned nthreads, uint64_t ops, Body body)
+  {
+    using Clock = std::chrono::steady_clock;
+
+    // Each worker times itself: the releasing thread may only get to run
+    // after the workers are done, e.g. on a single CPU
+    std::vector<Clock::time_point> begins(nthreads);
+    std::vector<Clock::time_point> ends(nthreads);
+    std::barrier start(nthreads);
+    {
+      std::vector<std::jthread> threads;
+      threads.reserve(nthreads);
+      for (unsigned t = 0; t < nthreads; t++)
+      {
+        threads.emplace_back([&, t] {
+          start.arrive_and_wait();
+          begins[t] = Clock::now();
+          for (uint64_t i = 0; i < ops; i++)
+          {
+            body();
+          }
+          ends[t] = Clock::now();
+        });
+      }
+    }
+
+    // From the first start to the last finish
+    auto begin = *std::min_element(begins.begin(), begins.end());
+    auto end = *std::max_element(ends.begin(), ends.end());
+    return std::chrono::duration<double, std::nano>(end - begin).count() /
+           static_cast<double>(ops * nthreads);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  uint64_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000ULL;
+  unsigned max_threads = argc > 2
+    ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+    : 2 * std::max(1U, std::thread::hardware_concurrency());
+
+  std::printf("%8s %18s %18s %8s\n", "threads", "atomic (ns/op)",
+              "per-cpu (ns/op)", "speedup");
+
+  for (unsigned nthreads = 1; nthreads <= max_threads; nthreads *= 2)
+  {
+    std::atomic<uint32_t> shared{0};
+    double shared_ns = run(nthreads, ops, [&] {
+      shared.fetch_add(1, std::memory_order::seq_cst);
+      shared.fetch_sub(1, std::memory_order::seq_cst);
+    });
+
+    PerCpuCounter sharded;
+    double sharded_ns = run(nthreads, ops, [&] {
+      sharded.add(1);
+      sharded.sub(1);
+    });
+
+    // Every add was paired with a sub; totals must be exact
+    if (shared.load() != 0 || sharded.load() != 0)
+    {
+      std::fprintf(stderr, "counter total is not exact\n");
+      return EXIT_FAILURE;
+    }
+
+    std::printf("%8u %18.2f %18.2f %7.2fx\n", nthreads, shared_ns, sharded_ns,
+                shared_ns / sharded_ns);
+  }
+
+  return EXIT_SUCCESS;
+}
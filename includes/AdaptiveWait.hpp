@@ -0,0 +1,250 @@
+/**
+ *  ===========================================================================
+ * /                              AdaptiveWait                                /
+ * ===========================================================================
+ *      -- Spin, then yield, then park on a futex, tuned by past wake-ups --
+ *
+ * > AdaptiveWaiter blocks a thread until a condition published by another
+ *   thread holds. Waits that end quickly are caught while spinning, long
+ *   ones sleep in the kernel without burning a core
+ *
+ * > The class has the following public methods:-
+ *   (+) void wait(<ready>) - Blocks until `ready()` returns true
+ *   (+) bool wait_until(<ready>, <deadline>)
+ *              - Same as above, but gives up at `deadline` (steady_clock);
+ *                returns the last result of `ready()`
+ *   (+) void notify_one(), void notify_all()
+ *              - Wakes one or every parked waiter; call after making the
+ *                condition true
+ *   (+) std::chrono::nanoseconds spin_budget() - Returns the current spin
+ *                                                budget
+ *
+ * > A wait checks `ready()` between `pause` instructions for up to the spin
+ *   budget, then between YIELD_ROUNDS sched_yield() calls, then parks on a
+ *   futex until notified.
+ * > The spin budget follows the wake-ups observed: a wait ending within
+ *   MAX_SPIN moves the budget towards twice its duration, a longer one moves
+ *   it back towards MIN_SPIN. Handoffs in quick succession are therefore
+ *   caught by spinning, while an idle waiter soon parks almost at once.
+ * > Notifying costs a fence and one load while nobody is parked; the futex
+ *   is only woken for parked waiters.
+ * > `ready()` must only read state the notifier wrote before notifying, and
+ *   may be called any number of times.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#include <cstdint>
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+/// @brief Spin-then-park wait with a spin budget adapting to wake latency
+class AdaptiveWaiter
+{
+public:
+  // Magic number: Bounds and starting point of the spin budget, in ns; the
+  // upper bound is about the cost of parking and being woken
+  static constexpr int64_t MIN_SPIN_NS = 256;
+  static constexpr int64_t MAX_SPIN_NS = 50'000;
+  static constexpr int64_t INITIAL_SPIN_NS = 4'000;
+  // Magic number: sched_yield() calls between spinning and parking
+  static constexpr unsigned YIELD_ROUNDS = 4U;
+
+  AdaptiveWaiter(const AdaptiveWaiter&) = delete;
+  AdaptiveWaiter& operator= (const AdaptiveWaiter&) = delete;
+  AdaptiveWaiter(AdaptiveWaiter&&) = delete;
+  AdaptiveWaiter& operator= (AdaptiveWaiter&&) = delete;
+
+  AdaptiveWaiter() = default;
+
+  // Blocks until `ready()` holds
+  template <typename Ready>
+  void wait(Ready&& ready) noexcept
+  {
+    wait_until(ready, std::chrono::steady_clock::time_point::max());
+  }
+
+  /**
+   * Blocks until `ready()` holds or `deadline` passes
+   *
+   * @param ready Condition to wait for
+   * @param deadline Time to give up at
+   * @returns Whether `ready()` held
+   */
+  template <typename Ready>
+  bool wait_until(Ready&& ready, std::chrono::steady_clock::time_point deadline) noexcept
+  {
+    if (ready())
+    {
+      return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t budget = spin_ns_.load(std::memory_order::relaxed);
+
+    // Spins, reading the clock once per batch of pauses
+    for (;;)
+    {
+      for (unsigned i = 0; i < SPINS_PER_CHECK; i++)
+      {
+        pause();
+      }
+      if (ready())
+      {
+        adapt(elapsed_ns(start));
+        return true;
+      }
+      auto now = std::chrono::steady_clock::now();
+      if (now >= deadline)
+      {
+        return false;
+      }
+      if ((now - start).count() >= budget)
+      {
+        break;
+      }
+    }
+
+    for (unsigned i = 0; i < YIELD_ROUNDS; i++)
+    {
+      std::this_thread::yield();
+      if (ready())
+      {
+        adapt(elapsed_ns(start));
+        return true;
+      }
+    }
+
+    bool held = park(ready, deadline);
+    if (held)
+    {
+      adapt(elapsed_ns(start));
+    }
+    return held;
+  }
+
+  // Wakes one parked waiter
+  void notify_one() noexcept
+  {
+    notify(1);
+  }
+
+  // Wakes every parked waiter
+  void notify_all() noexcept
+  {
+    notify(INT_MAX);
+  }
+
+  // Returns the current spin budget
+  std::chrono::nanoseconds spin_budget() const noexcept
+  {
+    return std::chrono::nanoseconds(spin_ns_.load(std::memory_order::relaxed));
+  }
+
+private:
+  // Magic number: Pauses between two clock reads while spinning
+  static constexpr unsigned SPINS_PER_CHECK = 32U;
+  // Magic number: Weight of a new wake-up in the budget, as a shift
+  static constexpr unsigned ADAPT_SHIFT = 2U;
+
+  static void pause() noexcept
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  static int64_t elapsed_ns(std::chrono::steady_clock::time_point start) noexcept
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start
+    ).count();
+  }
+
+  // Moves the spin budget towards what a wait of `waited` ns asked for
+  void adapt(int64_t waited) noexcept
+  {
+    int64_t target = waited <= MAX_SPIN_NS ? 2 * waited : MIN_SPIN_NS;
+    int64_t budget = spin_ns_.load(std::memory_order::relaxed);
+    budget += (target - budget) / (1 << ADAPT_SHIFT);
+    spin_ns_.store(std::clamp(budget, MIN_SPIN_NS, MAX_SPIN_NS), std::memory_order::relaxed);
+  }
+
+  // Sleeps on the futex until `ready()` holds or `deadline` passes
+  template <typename Ready>
+  bool park(Ready& ready, std::chrono::steady_clock::time_point deadline) noexcept
+  {
+    // Announcing the sleeper before the last check pairs with the fence in
+    // notify(): either the notifier sees the sleeper, or the waiter sees
+    // the condition
+    sleepers_.fetch_add(1, std::memory_order::seq_cst);
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    bool held = false;
+    for (;;)
+    {
+      uint32_t key = seq_.load(std::memory_order::seq_cst);
+      if (ready())
+      {
+        held = true;
+        break;
+      }
+
+      timespec timeout{};
+      timespec* relative = nullptr;
+      if (deadline != std::chrono::steady_clock::time_point::max())
+      {
+        auto left = deadline - std::chrono::steady_clock::now();
+        if (left <= std::chrono::steady_clock::duration::zero())
+        {
+          break;
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+        timeout.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+        timeout.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+        relative = &timeout;
+      }
+      // Returns at once if a notification bumped seq_ since `key`
+      syscall(
+        SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAIT_PRIVATE,
+        key, relative, nullptr, 0
+      );
+    }
+    sleepers_.fetch_sub(1, std::memory_order::relaxed);
+    return held;
+  }
+
+  void notify(int count) noexcept
+  {
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    if (sleepers_.load(std::memory_order::relaxed) == 0)
+    {
+      return;
+    }
+    seq_.fetch_add(1, std::memory_order::seq_cst);
+    syscall(
+      SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAKE_PRIVATE,
+      count, nullptr, nullptr, 0
+    );
+  }
+
+  // The futex operates on the atomic's storage
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+
+  // Futex word, bumped by notifications reaching parked waiters
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<uint32_t> sleepers_{0};
+  std::atomic<int64_t> spin_ns_{INITIAL_SPIN_NS};
+};
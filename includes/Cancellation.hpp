@@ -0,0 +1,434 @@
+/**
+ *  ===========================================================================
+ * /                             Cancellation                                 /
+ * ===========================================================================
+ *     -- A lightweight alternative to std::stop_source for wide fan-out --
+ *
+ * > Cancellation provides CancellationSource, CancellationToken and
+ *   CancellationCallback, which mirror std::stop_source, std::stop_token and
+ *   std::stop_callback
+ *
+ * > CancellationSource has the following public methods:-
+ *   (+) bool request_stop([<dispatch threads>]) - Requests a stop and runs
+ *              every registered callback; when more than one dispatch thread
+ *              is allowed and enough callbacks are registered, they run on
+ *              that many threads in parallel
+ *   (+) bool stop_requested() - Checks if a stop was requested
+ *   (+) CancellationToken get_token() - Returns a borrowed token
+ *   (+) void reset() - Re-arms a source once no token or callback taken
+ *              from it is in use, so that it can be handed out again
+ *
+ * > CancellationToken has the following public methods:-
+ *   (+) bool stop_requested() - Checks if a stop was requested
+ *   (+) bool stop_possible() - Checks if the token refers to a source
+ *
+ * > CancellationCallback (<token>, <callable>) registers `callable` to be run
+ *   when a stop is requested (or immediately, if it already was) and
+ *   deregisters it on destruction, waiting for it to finish if it is
+ *   currently running on another thread. A callback may destroy itself or
+ *   any callback that has not started yet; the latter then never runs.
+ *
+ * > Tokens are a plain pointer to the source: copying them touches no shared
+ *   refcount and allocates nothing. In turn, the source must outlive every
+ *   token and callback taken from it.
+ * > Callbacks are intrusive nodes living inside CancellationCallback.
+ *   Registration is lock-free (a single CAS onto an incoming stack). Removal
+ *   takes a short spinlock, folds the incoming stack into the main list and
+ *   unlinks in O(1). Dispatch claims all callbacks under that spinlock at
+ *   once, then the dispatch threads pop them one by one under it and run
+ *   each after releasing it, so claimed callbacks can still be unlinked.
+ */
+
+#pragma once
+
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+
+class CancellationSource;
+
+/// @brief Borrowed, non-refcounted view of a CancellationSource
+class CancellationToken
+{
+public:
+  CancellationToken() noexcept = default;
+
+  // Checks if a stop was requested
+  bool stop_requested() const noexcept;
+
+  // Checks if the token refers to a source
+  bool stop_possible() const noexcept
+  {
+    return source_ != nullptr;
+  }
+
+private:
+  friend class CancellationSource;
+  template <typename Callback> friend class CancellationCallback;
+
+  explicit CancellationToken(const CancellationSource* source) noexcept
+    : source_(source)
+  { }
+
+  const CancellationSource* source_ = nullptr;
+};
+
+namespace cancellation_detail
+{
+  // Intrusive list node embedded into every CancellationCallback
+  struct Node_t
+  {
+    enum State_t : uint32_t { registered, claimed, running, done, removed };
+
+    void (*invoke)(void*) noexcept = nullptr;
+    // Object passed to invoke (the owning CancellationCallback)
+    void* context = nullptr;
+    Node_t* next = nullptr;
+    Node_t* prev = nullptr;
+    std::atomic<uint32_t> state{registered};
+  };
+}
+
+/// @brief Source of stop requests and owner of the callback list
+class CancellationSource
+{
+  using Node_t = cancellation_detail::Node_t;
+
+  // Magic number: Minimum callbacks given to each parallel dispatch thread
+  static constexpr size_t DISPATCH_GRAIN = 256UL;
+
+public:
+  CancellationSource(const CancellationSource&) = delete;
+  CancellationSource& operator= (const CancellationSource&) = delete;
+  CancellationSource(CancellationSource&&) = delete;
+  CancellationSource& operator= (CancellationSource&&) = delete;
+
+  CancellationSource() noexcept = default;
+
+  // Returns a token borrowing this source
+  CancellationToken get_token() const noexcept
+  {
+    return CancellationToken(this);
+  }
+
+  // Checks if a stop was requested
+  bool stop_requested() const noexcept
+  {
+    return stopped_.load(std::memory_order::acquire);
+  }
+
+  // Re-arms the source; no callback may be registered and no token in use
+  void reset() noexcept
+  {
+    incoming_.store(nullptr, std::memory_order::relaxed);
+    head_ = nullptr;
+    stopped_.store(false, std::memory_order::release);
+  }
+
+  /**
+   * Requests a stop and runs every registered callback
+   *
+   * @param dispatch_threads Maximum number of threads (including the calling
+   *                         one) callbacks may be spread over
+   * @returns True if this call requested the stop, false if a stop was
+   *          already requested
+   */
+  bool request_stop(unsigned dispatch_threads = 1) noexcept
+  {
+    if (stopped_.exchange(true, std::memory_order::acq_rel))
+    {
+      return false;
+    }
+
+    // Heads the claimed callbacks, so that any of them can be unlinked
+    Node_t claimed;
+    size_t count = 0;
+    {
+      SpinGuard guard(list_lock_);
+      // New registrations from here on run inline
+      fold_incoming(incoming_.exchange(stopped_marker(), std::memory_order::acq_rel));
+
+      for (Node_t* node = head_; node != nullptr; node = node->next)
+      {
+        node->state.store(Node_t::claimed, std::memory_order::relaxed);
+        ++count;
+      }
+      claimed.next = head_;
+      if (head_)
+      {
+        head_->prev = &claimed;
+      }
+      head_ = nullptr;
+    }
+
+    size_t nthreads = std::min<size_t>(
+      std::max(dispatch_threads, 1U),
+      (count + DISPATCH_GRAIN - 1) / DISPATCH_GRAIN
+    );
+
+    // Helper threads pop from the same list as the calling thread; whatever
+    // they could not be started for runs on the calling thread
+    std::vector<std::jthread> helpers;
+    try
+    {
+      if (nthreads > 1)
+      {
+        helpers.reserve(nthreads - 1);
+      }
+      for (size_t i = 0; i + 1 < nthreads; i++)
+      {
+        helpers.emplace_back([this, &claimed] {
+          run_claimed(claimed);
+        });
+      }
+    }
+    catch (...)
+    { }
+    run_claimed(claimed);
+
+    return true;
+  }
+
+private:
+  friend class CancellationToken;
+  template <typename Callback> friend class CancellationCallback;
+
+  // Test-and-test-and-set spinlock guarding the main list
+  struct SpinGuard
+  {
+    explicit SpinGuard(std::atomic<bool>& lock) noexcept : lock_(lock)
+    {
+      while (lock_.exchange(true, std::memory_order::acquire))
+      {
+        while (lock_.load(std::memory_order::relaxed))
+        {
+          std::this_thread::yield();
+        }
+      }
+    }
+    ~SpinGuard()
+    {
+      lock_.store(false, std::memory_order::release);
+    }
+    std::atomic<bool>& lock_;
+  };
+
+  static Node_t* stopped_marker() noexcept
+  {
+    return reinterpret_cast<Node_t*>(uintptr_t{1});
+  }
+
+  // Runs the callbacks following `claimed` until none are left
+  void run_claimed(Node_t& claimed) noexcept
+  {
+    for (;;)
+    {
+      // Popped one at a time, so removal can unlink any not yet started
+      Node_t* node = nullptr;
+      {
+        SpinGuard guard(list_lock_);
+        node = claimed.next;
+        if (node == nullptr)
+        {
+          return;
+        }
+        claimed.next = node->next;
+        if (node->next)
+        {
+          node->next->prev = &claimed;
+        }
+        node->state.store(Node_t::running, std::memory_order::relaxed);
+      }
+
+      // The node may be destroyed as soon as it is marked done, hence
+      // waiters are woken through the source, which outlives it. The
+      // callback may stop another source, which nests a dispatch on this
+      // thread, so the outer callback is restored afterwards
+      Node_t* outer = std::exchange(running_, node);
+      node->invoke(node->context);
+      // A callback that destroyed itself cleared running_, and its node is
+      // gone
+      bool alive = running_ == node;
+      running_ = outer;
+      if (alive)
+      {
+        node->state.store(Node_t::done, std::memory_order::release);
+      }
+      completed_.fetch_add(1, std::memory_order::release);
+      completed_.notify_all();
+    }
+  }
+
+  // Registers `node`; returns false if a stop was already requested
+  bool push(Node_t* node) const noexcept
+  {
+    Node_t* head = incoming_.load(std::memory_order::acquire);
+    do
+    {
+      if (head == stopped_marker())
+      {
+        return false;
+      }
+      node->next = head;
+    }
+    while (!incoming_.compare_exchange_weak(
+      head, node, std::memory_order::release, std::memory_order::acquire
+    ));
+    return true;
+  }
+
+  // Deregisters `node`, waiting for it if it is being run
+  void remove(Node_t* node) const noexcept
+  {
+    {
+      SpinGuard guard(list_lock_);
+      uint32_t state = node->state.load(std::memory_order::relaxed);
+      if (state == Node_t::registered)
+      {
+        Node_t* incoming = incoming_.load(std::memory_order::acquire);
+        while (
+          incoming != stopped_marker() &&
+          !incoming_.compare_exchange_weak(
+            incoming, nullptr, std::memory_order::acq_rel
+          )
+        )
+        { }
+        if (incoming != stopped_marker())
+        {
+          fold_incoming(incoming);
+        }
+      }
+      if (state == Node_t::registered || state == Node_t::claimed)
+      {
+        // Claimed nodes always follow the dispatcher's list head
+        (node->prev ? node->prev->next : head_) = node->next;
+        if (node->next)
+        {
+          node->next->prev = node->prev;
+        }
+        node->state.store(Node_t::removed, std::memory_order::relaxed);
+        return;
+      }
+    }
+
+    // Being run by a dispatcher; a callback may destroy itself while running
+    if (running_ == node)
+    {
+      running_ = nullptr;
+      return;
+    }
+    // Sampling completed_ before the state means a callback finishing
+    // after the check changes it, so the wait cannot miss it
+    for (;;)
+    {
+      uint32_t seen = completed_.load(std::memory_order::acquire);
+      if (node->state.load(std::memory_order::acquire) == Node_t::done)
+      {
+        return;
+      }
+      completed_.wait(seen, std::memory_order::acquire);
+    }
+  }
+
+  // Moves a detached incoming stack onto the doubly linked main list
+  void fold_incoming(Node_t* node) const noexcept
+  {
+    while (node != nullptr && node != stopped_marker())
+    {
+      Node_t* next = node->next;
+      node->prev = nullptr;
+      node->next = head_;
+      if (head_)
+      {
+        head_->prev = node;
+      }
+      head_ = node;
+      node = next;
+    }
+  }
+
+  // Innermost callback being run by the calling thread, lets it destroy
+  // itself; cleared when it does
+  static inline thread_local Node_t* running_ = nullptr;
+
+  std::atomic<bool> stopped_{false};
+  // Lock-free registration stack; stopped_marker() once stopped
+  mutable std::atomic<Node_t*> incoming_{nullptr};
+  // Doubly linked list of registered callbacks, guarded by list_lock_ like
+  // the list of claimed ones during a dispatch
+  mutable Node_t* head_ = nullptr;
+  mutable std::atomic<bool> list_lock_{false};
+  // Bumped after every dispatched callback; remove() waits on it
+  mutable std::atomic<uint32_t> completed_{0};
+};
+
+inline bool CancellationToken::stop_requested() const noexcept
+{
+  return source_ && source_->stop_requested();
+}
+
+/// @brief Runs a callable when the source of a token is stopped
+template <typename Callback>
+class CancellationCallback
+{
+public:
+  CancellationCallback(const CancellationCallback&) = delete;
+  CancellationCallback& operator= (const CancellationCallback&) = delete;
+  CancellationCallback(CancellationCallback&&) = delete;
+  CancellationCallback& operator= (CancellationCallback&&) = delete;
+
+  /**
+   * Registers `callback` with the source of `token`, or runs it immediately
+   * if a stop was already requested
+   *
+   * @param token Token to observe
+   * @param callback Callable run once on stop
+   */
+  template <typename C>
+  explicit CancellationCallback(CancellationToken token, C&& callback)
+    noexcept(std::is_nothrow_constructible_v<Callback, C>)
+    : callback_(std::forward<C>(callback))
+  {
+    static_assert(std::is_nothrow_invocable_v<Callback&>,
+                  "Cancellation callbacks must be noexcept");
+
+    node_.invoke = [] (void* self) noexcept {
+      static_cast<CancellationCallback*>(self)->callback_();
+    };
+    node_.context = this;
+
+    if (token.source_ == nullptr)
+    {
+      return;
+    }
+    if (token.source_->push(&node_))
+    {
+      source_ = token.source_;
+      return;
+    }
+    callback_();
+  }
+
+  ~CancellationCallback()
+  {
+    if (source_)
+    {
+      source_->remove(&node_);
+    }
+  }
+
+private:
+  Callback callback_;
+  cancellation_detail::Node_t node_;
+  const CancellationSource* source_ = nullptr;
+};
+
+template <typename Callback>
+CancellationCallback(CancellationToken, Callback) -> CancellationCallback<Callback>;
@@ -0,0 +1,543 @@
+/**
+ *  ===========================================================================
+ * /                              ElasticPool                                 /
+ * ===========================================================================
+ *      -- A task pool over ThreadManager that resizes with its workload --
+ *
+ * > ElasticPool runs submitted tasks on worker threads spawned through a
+ *   ThreadManager, growing the pool while the queue backs up and workers are
+ *   blocked, and shrinking it again once workers sit idle
+ *
+ * > Utilities aside from the class:-
+ *   (+) struct ElasticPoolConfig_t - Bounds and tuning of the pool
+ *   (+) class ElasticPool::BlockingScope - Marks the calling worker as blocked
+ *                                          for the lifetime of the scope
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor (<thread manager>[, <config>]) (throws unless
+ *                   1 <= min_workers <= max_workers)
+ *
+ *   (+) void submit(<callable>) - Queues `callable` (invoked without
+ *                                 arguments)
+ *   (+) void shutdown() - Stops accepting tasks, drains the queue and waits
+ *                         for every pool thread to exit
+ *
+ *   (+) size_t workers() - Returns the number of live workers
+ *   (+) size_t idle_workers() - Returns the number of workers waiting for
+ *                               tasks
+ *   (+) size_t blocked_workers() - Returns the number of workers found
+ *                                  blocked
+ *   (+) size_t queued() - Returns the number of tasks waiting to run
+ *
+ * > A controller thread checks the pool every `tick`. The pool grows only
+ *   when tasks are queued, no worker is idle and fewer than `cpu_target`
+ *   workers are runnable, i.e. the missing throughput is due to workers
+ *   blocked in syscalls rather than a lack of CPUs. The condition must hold
+ *   for `grow_ticks` consecutive ticks, which filters out short bursts.
+ * > A worker counts as blocked while it is inside a BlockingScope, or (with
+ *   `probe_kernel_state`) while the kernel reports its thread as sleeping (S)
+ *   or in uninterruptible sleep (D) in the middle of a task.
+ * > A worker idle for `idle_timeout` exits, unless the pool is at
+ *   `min_workers`.
+ * > Idle workers and shutdown() wait through AdaptiveWaiter, so a task
+ *   submitted shortly after a worker ran out of tasks is picked up while it
+ *   still spins, and a pool idling for long sleeps on a futex.
+ * > A global stop request on the ThreadManager makes every pool thread exit;
+ *   queued tasks are then destroyed without running, and submit() throws.
+ * > ElasticPool is an alias of BasicElasticPool over ThreadManager; a
+ *   BasicElasticPool<M> runs over any BasicThreadManager M whose lock policy
+ *   allows calls from several threads (the controller spawns workers).
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <AdaptiveWait.hpp>
+#include <Cancellation.hpp>
+#include <ThreadCache.hpp>
+#include <ThreadManager.hpp>
+
+
+///  @brief Bounds and tuning of an ElasticPool
+struct ElasticPoolConfig_t
+{
+  // Workers kept alive even when idle
+  size_t min_workers = 1;
+  // Hard upper bound on workers
+  size_t max_workers = 4 * std::max(1U, std::thread::hardware_concurrency());
+  // Runnable workers the pool aims for; 0 picks the number of CPUs
+  size_t cpu_target = 0;
+  // Interval at which the controller checks the pool
+  std::chrono::milliseconds tick = std::chrono::milliseconds(10);
+  // Consecutive ticks of backlog required before growing
+  unsigned grow_ticks = 2;
+  // Idle time after which a worker above `min_workers` exits
+  std::chrono::milliseconds idle_timeout = std::chrono::seconds(1);
+  // Also treat workers the kernel reports as sleeping as blocked
+  bool probe_kernel_state = true;
+};
+
+/// @brief Worker state of every ElasticPool, independent of its manager
+class ElasticPoolBase
+{
+protected:
+  // Magic number: Assumed size of a cache line
+  static constexpr size_t CACHE_LINE = 64UL;
+
+  enum WORKER_STATE_ENM : uint8_t { free, idle, running, blocked };
+
+  // Per-worker state, written by its worker and scanned by the controller
+  struct alignas(CACHE_LINE) Slot_t
+  {
+    std::atomic<uint8_t> state{WORKER_STATE_ENM::free};
+    std::atomic<pid_t> tid{0};
+  };
+
+  // Slot of the calling thread, if it is a pool worker
+  static inline thread_local Slot_t* current_slot_ = nullptr;
+
+public:
+  /// @brief Marks the calling pool worker as blocked while alive
+  class BlockingScope
+  {
+  public:
+    BlockingScope(const BlockingScope&) = delete;
+    BlockingScope& operator= (const BlockingScope&) = delete;
+
+    BlockingScope() noexcept : slot_(current_slot_)
+    {
+      if (slot_)
+      {
+        previous_ = slot_->state.exchange(
+          WORKER_STATE_ENM::blocked,
+          std::memory_order::relaxed
+        );
+      }
+    }
+    ~BlockingScope()
+    {
+      if (slot_)
+      {
+        slot_->state.store(previous_, std::memory_order::relaxed);
+      }
+    }
+
+  private:
+    Slot_t* slot_;
+    uint8_t previous_ = WORKER_STATE_ENM::running;
+  };
+};
+
+/// @brief Task pool over a BasicThreadManager sized by queue depth and
+///        blocking
+template <typename Manager = ThreadManager>
+class BasicElasticPool : public ElasticPoolBase
+{
+  // Wakes every pool thread on a global stop request
+  struct Waker_t
+  {
+    void operator() () const noexcept
+    {
+      {
+        std::lock_guard lock(pool->mtx_);
+        pool->controller_cv_.notify_all();
+      }
+      pool->work_waiter_.notify_all();
+    }
+    BasicElasticPool* pool;
+  };
+
+public:
+  BasicElasticPool(const BasicElasticPool&) = delete;
+  BasicElasticPool& operator= (const BasicElasticPool&) = delete;
+  BasicElasticPool(BasicElasticPool&&) = delete;
+  BasicElasticPool& operator= (BasicElasticPool&&) = delete;
+
+  BasicElasticPool() = delete;
+
+  /**
+   * Constructs a pool and starts its minimum number of workers
+   *
+   * @param manager Manager spawning the pool threads; must outlive the pool
+   * @param config Bounds and tuning of the pool
+   */
+  explicit BasicElasticPool(Manager& manager, ElasticPoolConfig_t config = {})
+    : manager_(manager),
+      config_(config),
+      slots_(std::make_unique<Slot_t[]>(std::max<size_t>(config.max_workers, 1))),
+      stop_callback_(manager.global_token(), Waker_t{this})
+  {
+    // Without a worker, shutdown() would strand the queued tasks
+    if (config_.min_workers == 0 || config_.min_workers > config_.max_workers)
+    {
+      throw std::invalid_argument("ElasticPool bounds are inconsistent");
+    }
+    if (config_.cpu_target == 0)
+    {
+      config_.cpu_target = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    try
+    {
+      std::lock_guard lock(mtx_);
+      spawn_locked(PoolThread_t::controller);
+      for (size_t i = 0; i < config_.min_workers; i++)
+      {
+        spawn_locked(PoolThread_t::worker);
+      }
+    }
+    catch (...)
+    {
+      shutdown();
+      throw;
+    }
+  }
+
+  ~BasicElasticPool()
+  {
+    shutdown();
+  }
+
+  // Queues `task`, invoked without arguments
+  template <typename Callable>
+  void submit(Callable&& task)
+  {
+    {
+      std::lock_guard lock(mtx_);
+      if (stopping_ || manager_.stop_requested_all())
+      {
+        throw std::logic_error("ElasticPool is shut down");
+      }
+      queue_.emplace_back(std::forward<Callable>(task));
+      work_seq_.fetch_add(1, std::memory_order::release);
+    }
+    work_waiter_.notify_one();
+  }
+
+  // Stops accepting tasks, drains the queue and waits for all pool threads
+  void shutdown() noexcept
+  {
+    {
+      std::lock_guard lock(mtx_);
+      stopping_ = true;
+      work_seq_.fetch_add(1, std::memory_order::release);
+      controller_cv_.notify_all();
+    }
+    work_waiter_.notify_all();
+    exit_waiter_.wait([this] { return threads_.load(std::memory_order::acquire) == 0; });
+    // The last thread notifies under mtx_; taking it once lets that finish
+    // before the pool may be destroyed
+    std::lock_guard lock(mtx_);
+  }
+
+  // Returns the number of live workers
+  size_t workers()
+  {
+    std::lock_guard lock(mtx_);
+    return workers_;
+  }
+
+  // Returns the number of workers waiting for tasks
+  size_t idle_workers()
+  {
+    std::lock_guard lock(mtx_);
+    return idle_;
+  }
+
+  // Returns the number of workers currently found blocked
+  size_t blocked_workers() const
+  {
+    size_t blocked = 0;
+    for (size_t i = 0; i < config_.max_workers; i++)
+    {
+      uint8_t state = slots_[i].state.load(std::memory_order::relaxed);
+      if (
+        state == WORKER_STATE_ENM::blocked ||
+        (
+          state == WORKER_STATE_ENM::running &&
+          config_.probe_kernel_state &&
+          kernel_reports_sleeping(slots_[i].tid.load(std::memory_order::relaxed))
+        )
+      )
+      {
+        ++blocked;
+      }
+    }
+    return blocked;
+  }
+
+  // Returns the number of queued tasks
+  size_t queued()
+  {
+    std::lock_guard lock(mtx_);
+    return queue_.size();
+  }
+
+private:
+  enum class PoolThread_t { worker, controller };
+
+  // Spawns a pool thread through the manager; caller holds mtx_
+  void spawn_locked(PoolThread_t kind)
+  {
+    ++threads_;
+    if (kind == PoolThread_t::worker)
+    {
+      ++workers_;
+    }
+
+    try
+    {
+      manager_.spawn_thread(
+        [this, kind] (std::stop_token, CancellationToken global) {
+          if (kind == PoolThread_t::worker)
+          {
+            worker_loop(global);
+          }
+          else
+          {
+            controller_loop(global);
+          }
+
+          // Destroyed once mtx_ is released, task destructors may block
+          std::deque<UniqueTask> discarded;
+          std::lock_guard lock(mtx_);
+          if (--threads_ == 0)
+          {
+            if (global.stop_requested())
+            {
+              discarded.swap(queue_);
+            }
+            exit_waiter_.notify_all();
+          }
+        }
+      );
+    }
+    catch (...)
+    {
+      --threads_;
+      if (kind == PoolThread_t::worker)
+      {
+        --workers_;
+      }
+      throw;
+    }
+  }
+
+  // Runs queued tasks until stopped or idle for too long
+  void worker_loop(CancellationToken global)
+  {
+    Slot_t* slot = claim_slot();
+    current_slot_ = slot;
+
+    // Set when the worker runs out of tasks, kept across wake-ups that find
+    // the queue emptied by another worker
+    auto idle_deadline = std::chrono::steady_clock::time_point::max();
+    std::unique_lock lock(mtx_);
+    for (;;)
+    {
+      if (global.stop_requested() || (stopping_ && queue_.empty()))
+      {
+        break;
+      }
+
+      if (!queue_.empty())
+      {
+        UniqueTask task = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        slot->state.store(WORKER_STATE_ENM::running, std::memory_order::relaxed);
+        task();
+        task = UniqueTask();
+
+        lock.lock();
+        idle_deadline = std::chrono::steady_clock::time_point::max();
+        continue;
+      }
+
+      if (idle_deadline == std::chrono::steady_clock::time_point::max())
+      {
+        idle_deadline = std::chrono::steady_clock::now() + config_.idle_timeout;
+      }
+      ++idle_;
+      slot->state.store(WORKER_STATE_ENM::idle, std::memory_order::relaxed);
+      // Bumped under mtx_ by every submission and by shutdown(), hence none
+      // is missed between the checks above and the wait
+      uint64_t seen = work_seq_.load(std::memory_order::relaxed);
+      lock.unlock();
+      bool woken = work_waiter_.wait_until([&] {
+        return work_seq_.load(std::memory_order::acquire) != seen ||
+               global.stop_requested();
+      }, idle_deadline);
+      lock.lock();
+      --idle_;
+
+      if (!woken)
+      {
+        if (workers_ > config_.min_workers)
+        {
+          break;
+        }
+        idle_deadline = std::chrono::steady_clock::time_point::max();
+      }
+    }
+
+    --workers_;
+    current_slot_ = nullptr;
+    slot->tid.store(0, std::memory_order::relaxed);
+    slot->state.store(WORKER_STATE_ENM::free, std::memory_order::release);
+  }
+
+  // Periodically grows the pool while blocked workers starve the queue
+  void controller_loop(CancellationToken global)
+  {
+    unsigned pressure_ticks = 0;
+
+    std::unique_lock lock(mtx_);
+    while (!stopping_ && !global.stop_requested())
+    {
+      controller_cv_.wait_for(lock, config_.tick, [&] {
+        return stopping_ || global.stop_requested();
+      });
+      if (stopping_ || global.stop_requested())
+      {
+        break;
+      }
+
+      if (queue_.empty() || idle_ > 0 || workers_ >= config_.max_workers)
+      {
+        pressure_ticks = 0;
+        continue;
+      }
+
+      // Probing the kernel state reads /proc; keep the pool unlocked
+      lock.unlock();
+      size_t blocked = blocked_workers();
+      lock.lock();
+
+      size_t runnable = workers_ - std::min(blocked, workers_);
+      if (runnable >= config_.cpu_target)
+      {
+        // CPU bound: more threads would only oversubscribe
+        pressure_ticks = 0;
+        continue;
+      }
+      if (++pressure_ticks < config_.grow_ticks)
+      {
+        continue;
+      }
+      pressure_ticks = 0;
+
+      size_t grow_by = std::min({
+        queue_.size(),
+        config_.cpu_target - runnable,
+        config_.max_workers - workers_
+      });
+      try
+      {
+        for (size_t i = 0; i < grow_by; i++)
+        {
+          spawn_locked(PoolThread_t::worker);
+        }
+      }
+      catch (...)
+      {
+        // Out of threads for now; the next ticks retry
+      }
+    }
+  }
+
+  // Claims a free state slot for the calling worker
+  Slot_t* claim_slot() noexcept
+  {
+    pid_t tid = gettid();
+    for (;;)
+    {
+      for (size_t i = 0; i < config_.max_workers; i++)
+      {
+        uint8_t expected = WORKER_STATE_ENM::free;
+        if (slots_[i].state.compare_exchange_strong(
+          expected, WORKER_STATE_ENM::running, std::memory_order::acquire
+        ))
+        {
+          slots_[i].tid.store(tid, std::memory_order::relaxed);
+          return &slots_[i];
+        }
+      }
+      // A worker counted towards the bound is still releasing its slot
+      std::this_thread::yield();
+    }
+  }
+
+  // Checks /proc for whether thread `tid` is sleeping (S) or in D state
+  static bool kernel_reports_sleeping(pid_t tid) noexcept
+  {
+    if (tid == 0)
+    {
+      return false;
+    }
+
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+    FILE* file = std::fopen(path, "re");
+    if (!file)
+    {
+      return false;
+    }
+    char buffer[512];
+    size_t n = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+    std::fclose(file);
+    buffer[n] = '\0';
+
+    // The state follows the parenthesised command name
+    const char* paren = std::strrchr(buffer, ')');
+    if (!paren || paren[1] == '\0' || paren[2] == '\0')
+    {
+      return false;
+    }
+    return paren[2] == 'S' || paren[2] == 'D';
+  }
+
+  Manager& manager_;
+  ElasticPoolConfig_t config_;
+  std::unique_ptr<Slot_t[]> slots_;
+
+  // Idle workers and shutdown() wait on these without holding mtx_
+  AdaptiveWaiter work_waiter_;
+  AdaptiveWaiter exit_waiter_;
+
+  // Guards everything below; the atomics are also read without it
+  std::mutex mtx_;
+  std::condition_variable controller_cv_;
+  std::deque<UniqueTask> queue_;
+  std::atomic<uint64_t> work_seq_{0};
+  // Live pool threads (workers and controller)
+  std::atomic<size_t> threads_{0};
+  size_t workers_ = 0;
+  size_t idle_ = 0;
+  bool stopping_ = false;
+
+  CancellationCallback<Waker_t> stop_callback_;
+};
+
+/// @brief ElasticPool over a ThreadManager with the default policies
+using ElasticPool = BasicElasticPool<>;
@@ -0,0 +1,239 @@
+/**
+ *  ===========================================================================
+ * /                               Heartbeat                                  /
+ * ===========================================================================
+ *         -- Progress timestamps of running work, for a watchdog --
+ *
+ * > HeartbeatTable holds one cache-line-padded slot per running work. Work
+ *   calls heartbeat() to report progress; a monitor scans the slots for work
+ *   that has not reported within a deadline
+ *
+ * > Utilities aside from the class:-
+ *   (+) void heartbeat() - Stamps the calling thread's slot with the current
+ *                          time; does nothing for unmonitored threads
+ *   (+) enum WATCHDOG_ACTION_ENM - What ThreadManager's watchdog does with
+ *                                  stalled work: flag it, or also request it
+ *                                  to stop
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor (<slots>)
+ *
+ *   (+) HeartbeatSlot_t* claim() - Takes a free slot for work about to be
+ *                                  launched; nullptr if all are taken
+ *   (+) static void arm(HeartbeatSlot_t* slot, <owner>, <stop>[, <local>])
+ *              - Records the thread and the local stop of the launched work
+ *                and starts watching it, unless it returned already
+ *   (+) static void attach(HeartbeatSlot_t* slot)
+ *              - Makes the slot the target of heartbeat() on the calling
+ *                thread, which runs the work
+ *   (+) static void release(HeartbeatSlot_t* slot) - Hands the slot back
+ *   (+) size_t scan(<deadline>, <on stall>)
+ *              - Calls `on_stall(owner, slot, generation)` once for each
+ *                work whose last heartbeat is older than `deadline`, and
+ *                returns the number of work currently stalled
+ *   (+) bool request_stop(HeartbeatSlot_t* slot, uint64_t generation)
+ *              - Requests the local stop of the work, unless the slot has
+ *                been released since `generation`
+ *
+ * > heartbeat() is a thread-local load, a clock read and a relaxed store to
+ *   a line no other writer touches. Slots are allocated up front, so claim()
+ *   and release() never allocate.
+ * > Work counts as stalled until its next heartbeat, then is flagged again
+ *   if it stalls once more.
+ * > A slot keeps the stop of its work, so stalled work is stopped without
+ *   the registry of the manager, which join() holds while waiting for it.
+ *   The stop is requested under the slot's lock, which release() takes too,
+ *   hence a local source is never stopped after its work returned.
+ */
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Cancellation.hpp>
+
+
+/// @brief What the watchdog does with stalled work
+enum class WATCHDOG_ACTION_ENM : uint8_t { flag, stop };
+
+/// @brief Heartbeat of one running work
+struct alignas(64) HeartbeatSlot_t
+{
+  // steady_clock time of the last heartbeat, in nanoseconds; never stale
+  // while the slot is free
+  std::atomic<int64_t> last_beat{INT64_MAX};
+  // Bumped by every claim, tells successive work of a slot apart
+  std::atomic<uint64_t> generation{0};
+  std::atomic<std::thread::id> owner{};
+  std::atomic<bool> busy{false};
+  // Generation last reported as stalled, 0 if none; monitor only
+  uint64_t flagged = 0;
+  // Local stop of the work, one of both; guarded by stop_mtx
+  std::stop_source stop_source{std::nostopstate};
+  CancellationSource* local_source = nullptr;
+  std::mutex stop_mtx;
+};
+
+namespace heartbeat_detail
+{
+  // Slot of the work running on this thread, if monitored
+  inline thread_local HeartbeatSlot_t* current = nullptr;
+
+  inline int64_t now() noexcept
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+  }
+}
+
+// Reports progress of the work running on the calling thread
+inline void heartbeat() noexcept
+{
+  if (HeartbeatSlot_t* slot = heartbeat_detail::current)
+  {
+    slot->last_beat.store(heartbeat_detail::now(), std::memory_order::relaxed);
+  }
+}
+
+/// @brief Fixed set of heartbeat slots scanned by a monitor
+class HeartbeatTable
+{
+public:
+  HeartbeatTable(const HeartbeatTable&) = delete;
+  HeartbeatTable& operator= (const HeartbeatTable&) = delete;
+  HeartbeatTable(HeartbeatTable&&) = delete;
+  HeartbeatTable& operator= (HeartbeatTable&&) = delete;
+
+  explicit HeartbeatTable(size_t slots)
+    : slots_(std::make_unique<HeartbeatSlot_t[]>(slots)),
+      size_(slots)
+  { }
+
+  // Takes a free slot, not watched until armed; nullptr if none is left
+  HeartbeatSlot_t* claim() noexcept
+  {
+    for (size_t i = 0; i < size_; i++)
+    {
+      HeartbeatSlot_t& slot = slots_[i];
+      bool expected = false;
+      if (!slot.busy.load(std::memory_order::relaxed) &&
+          slot.busy.compare_exchange_strong(expected, true, std::memory_order::acquire))
+      {
+        slot.generation.fetch_add(1, std::memory_order::release);
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Starts watching the work of `slot`; does nothing if it returned already
+   *
+   * @param owner Thread running the work
+   * @param stop_source Local stop of the work, if it takes a std::stop_token
+   * @param local_source Local stop of the work, if it takes a
+   *                     CancellationToken; must outlive the slot's release
+   */
+  static void arm(
+    HeartbeatSlot_t* slot,
+    std::thread::id owner,
+    const std::stop_source& stop_source,
+    CancellationSource* local_source = nullptr
+  ) noexcept
+  {
+    std::lock_guard lock(slot->stop_mtx);
+    if (!slot->busy.load(std::memory_order::relaxed))
+    {
+      return;
+    }
+    slot->stop_source = stop_source;
+    slot->local_source = local_source;
+    slot->owner.store(owner, std::memory_order::relaxed);
+    slot->last_beat.store(heartbeat_detail::now(), std::memory_order::relaxed);
+  }
+
+  // Makes `slot` the target of heartbeat() on the calling thread
+  static void attach(HeartbeatSlot_t* slot) noexcept
+  {
+    heartbeat_detail::current = slot;
+  }
+
+  // Hands `slot` back; heartbeat() on its thread does nothing afterwards
+  static void release(HeartbeatSlot_t* slot) noexcept
+  {
+    if (heartbeat_detail::current == slot)
+    {
+      heartbeat_detail::current = nullptr;
+    }
+    std::lock_guard lock(slot->stop_mtx);
+    slot->stop_source = std::stop_source(std::nostopstate);
+    slot->local_source = nullptr;
+    slot->last_beat.store(INT64_MAX, std::memory_order::relaxed);
+    slot->busy.store(false, std::memory_order::release);
+  }
+
+  /**
+   * Requests the local stop of the work of `slot`
+   *
+   * @param generation Generation the stall was reported for
+   * @returns False if the work returned meanwhile, or was already stopped
+   */
+  static bool request_stop(HeartbeatSlot_t* slot, uint64_t generation) noexcept
+  {
+    std::lock_guard lock(slot->stop_mtx);
+    if (slot->generation.load(std::memory_order::acquire) != generation ||
+        !slot->busy.load(std::memory_order::relaxed))
+    {
+      return false;
+    }
+    return slot->local_source ? slot->local_source->request_stop()
+                              : slot->stop_source.request_stop();
+  }
+
+  /**
+   * Flags work whose last heartbeat is older than `deadline`
+   *
+   * @param deadline Longest allowed time between two heartbeats
+   * @param on_stall Called with the owner, slot and generation of newly
+   *                 stalled work
+   * @returns The number of work currently stalled
+   */
+  template <typename OnStall>
+  size_t scan(std::chrono::nanoseconds deadline, OnStall&& on_stall)
+  {
+    int64_t limit = heartbeat_detail::now() - deadline.count();
+    size_t stalled = 0;
+    for (size_t i = 0; i < size_; i++)
+    {
+      HeartbeatSlot_t& slot = slots_[i];
+      uint64_t generation = slot.generation.load(std::memory_order::acquire);
+      if (slot.last_beat.load(std::memory_order::relaxed) >= limit)
+      {
+        // Lets the work be flagged again should it stall once more
+        slot.flagged = 0;
+        continue;
+      }
+      stalled++;
+      if (slot.flagged != generation)
+      {
+        slot.flagged = generation;
+        on_stall(slot.owner.load(std::memory_order::relaxed), &slot, generation);
+      }
+    }
+    return stalled;
+  }
+
+private:
+  std::unique_ptr<HeartbeatSlot_t[]> slots_;
+  size_t size_;
+};
@@ -0,0 +1,110 @@
+/**
+ *  ===========================================================================
+ * /                               JobPolicy                                  /
+ * ===========================================================================
+ *     -- Per-job OOM score, nice, I/O and CPU scheduling for child jobs --
+ *
+ * > JobPolicy applies scheduling knobs to a child between fork and exec, so
+ *   that under overload background jobs yield the CPU, the disk and, when
+ *   memory runs out, their lives before the launcher itself does
+ *
+ * > Utilities aside from the class:-
+ *   (+) enum CPU_POLICY_ENM - Scheduling policy of a job: inherited, normal
+ *                             (SCHED_OTHER), SCHED_BATCH or SCHED_IDLE
+ *   (+) enum IO_CLASS_ENM - I/O scheduling class of a job: inherited,
+ *                           realtime, best effort or idle
+ *   (+) struct JobPolicyConfig_t - The knobs of a job
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor ([<config>]) (throws for values out of range)
+ *
+ *   (+) int prepare_child() - Applies the policy to the calling process.
+ *                             Returns 0, or the errno of the first knob that
+ *                             failed. Is async-signal-safe and meant to be
+ *                             called in the child between fork and exec
+ *   (+) const JobPolicyConfig_t& config() - Returns the knobs
+ *
+ *   (+) static bool prioritize_thread([<nice>])
+ *              - Raises the calling thread of the launcher to `nice`;
+ *                threads it creates afterwards inherit that. Returns false
+ *                without the privilege to do so (CAP_SYS_NICE or
+ *                RLIMIT_NICE), throws on other errors
+ *
+ * > The supervisor side runs prioritize_thread() early on the main thread,
+ *   before the ThreadManager spawns anything, so that signal handling and
+ *   reaping keep their CPU share while jobs compete for the rest.
+ * > Children inherit the nice value of the thread that forked them, hence
+ *   prepare_child() always sets `nice` (0 by default), undoing the
+ *   supervisor's boost. It does so before any other knob, so the boost is
+ *   dropped even if a later knob fails. The OOM score, the I/O class and the
+ *   CPU policy are left as inherited unless configured.
+ * > Everything is validated and formatted in the constructor; the child
+ *   only issues syscalls (open, write, close, setpriority, ioprio_set and
+ *   sched_setscheduler), which is safe after forking a multi-threaded
+ *   parent.
+ */
+
+#pragma once
+
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// @brief Scheduling policy of a job
+enum class CPU_POLICY_ENM : uint8_t { inherit, normal, batch, idle };
+
+/// @brief I/O scheduling class of a job
+enum class IO_CLASS_ENM : uint8_t { inherit, realtime, best_effort, idle };
+
+///  @brief Scheduling knobs of a job
+struct JobPolicyConfig_t
+{
+  // Written to /proc/self/oom_score_adj, -1000 (never killed) to 1000
+  // (killed first); lowering it below the parent's needs CAP_SYS_RESOURCE
+  std::optional<int> oom_score_adj;
+  // -20 (highest) to 19 (lowest); negative values need CAP_SYS_NICE
+  int nice = 0;
+  CPU_POLICY_ENM cpu_policy = CPU_POLICY_ENM::inherit;
+  IO_CLASS_ENM io_class = IO_CLASS_ENM::inherit;
+  // Priority within the realtime and best effort classes, 0 (highest) to 7
+  int io_level = 4;
+};
+
+/// @brief Applies a JobPolicyConfig_t to a child between fork and exec
+class JobPolicy
+{
+public:
+  // Magic number: Nice value prioritize_thread() raises the supervisor to
+  static constexpr int SUPERVISOR_NICE = -10;
+
+  /**
+   * Validates `config` and prepares it for prepare_child()
+   *
+   * @param config Scheduling knobs of the job
+   */
+  explicit JobPolicy(JobPolicyConfig_t config = {});
+
+  // Applies the policy to the calling process (async-signal-safe)
+  int prepare_child() const noexcept;
+
+  const JobPolicyConfig_t& config() const noexcept
+  {
+    return config_;
+  }
+
+  // Raises the calling thread to `nice`; false without the privilege
+  static bool prioritize_thread(int nice = SUPERVISOR_NICE);
+
+private:
+  // Magic number: Fits "-1000\n"
+  static constexpr size_t OOM_TEXT_SIZE = 8UL;
+
+  JobPolicyConfig_t config_;
+  // oom_score_adj formatted up front, since the child must not allocate
+  char oom_text_[OOM_TEXT_SIZE] = {};
+  size_t oom_length_ = 0;
+  int ioprio_ = 0;
+};
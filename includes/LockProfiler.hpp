@@ -0,0 +1,171 @@
+/**
+ *  ===========================================================================
+ * /                              LockProfiler                                /
+ * ===========================================================================
+ *         -- Acquisition counts and wait/hold times of internal locks --
+ *
+ * > ProfiledLock wraps a Lockable and records how often it was acquired, how
+ *   often an acquisition had to wait, and for how long
+ *
+ * > Utilities aside from the class:-
+ *   (+) struct LockStats_t - Counters and log2 histograms of a ProfiledLock
+ *   (+) InternalLock - Lock of ThreadManager's registry and of ThreadCache:
+ *                      ProfiledLock<std::mutex> when built with
+ *                      PARALLELLAUNCHER_LOCK_PROFILING, else std::mutex
+ *   (+) is_profiled_lock_v<Lock> - Whether `Lock` is a ProfiledLock
+ *
+ * > The class has the following public methods:-
+ *   (+) void lock(), bool try_lock(), void unlock() - As the wrapped lock
+ *   (+) void record_hold(uint64_t ns) - Adds a hold time measured by a caller
+ *   (+) LockStats_t stats() - Returns a snapshot of the counters
+ *
+ * > Uncontended acquisitions cost one try_lock() and one counter update; only
+ *   acquisitions that have to wait read the clock. The counters are written
+ *   by the lock holder alone, hence updated with plain relaxed stores instead
+ *   of read-modify-writes, and read without stopping the lock's users.
+ * > Hold times are only measured where a caller asks for them, e.g. around
+ *   ThreadManager::join(), keeping the clock off the spawn path.
+ * > Histogram bucket `b` counts durations of [2^(b-1), 2^b) nanoseconds; the
+ *   last bucket is open-ended.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <mutex>
+#include <type_traits>
+
+#include <cstddef>
+#include <cstdint>
+
+
+// Magic number: Buckets of a LockStats_t histogram (the last one is >= ~1s)
+inline constexpr size_t LOCK_HISTOGRAM_BUCKETS = 32UL;
+
+///  @brief Snapshot of the counters of a ProfiledLock
+struct LockStats_t
+{
+  // Successful lock() and try_lock() calls
+  uint64_t acquisitions;
+  // lock() calls that found the lock held
+  uint64_t contended;
+  // Total time spent waiting by contended lock() calls
+  uint64_t wait_ns;
+  std::array<uint64_t, LOCK_HISTOGRAM_BUCKETS> wait_histogram;
+  // Hold times recorded through record_hold()
+  uint64_t holds;
+  uint64_t hold_ns;
+  std::array<uint64_t, LOCK_HISTOGRAM_BUCKETS> hold_histogram;
+};
+
+/// @brief Lockable wrapper counting acquisitions and timing contention
+template <typename Lock = std::mutex>
+class ProfiledLock
+{
+public:
+  void lock()
+  {
+    if (lock_.try_lock())
+    {
+      bump(acquisitions_);
+      return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    lock_.lock();
+    uint64_t waited = elapsed_ns(start);
+
+    bump(acquisitions_);
+    bump(contended_);
+    bump(wait_ns_, waited);
+    bump(wait_histogram_[bucket(waited)]);
+  }
+
+  bool try_lock()
+  {
+    if (lock_.try_lock())
+    {
+      bump(acquisitions_);
+      return true;
+    }
+    return false;
+  }
+
+  void unlock()
+  {
+    lock_.unlock();
+  }
+
+  // Adds a hold time measured by the caller; call while holding the lock
+  void record_hold(uint64_t ns) noexcept
+  {
+    bump(holds_);
+    bump(hold_ns_, ns);
+    bump(hold_histogram_[bucket(ns)]);
+  }
+
+  // Returns the counters; may be called without holding the lock
+  LockStats_t stats() const noexcept
+  {
+    LockStats_t stats{};
+    stats.acquisitions = acquisitions_.load(std::memory_order::relaxed);
+    stats.contended = contended_.load(std::memory_order::relaxed);
+    stats.wait_ns = wait_ns_.load(std::memory_order::relaxed);
+    stats.holds = holds_.load(std::memory_order::relaxed);
+    stats.hold_ns = hold_ns_.load(std::memory_order::relaxed);
+    for (size_t b = 0; b < LOCK_HISTOGRAM_BUCKETS; b++)
+    {
+      stats.wait_histogram[b] = wait_histogram_[b].load(std::memory_order::relaxed);
+      stats.hold_histogram[b] = hold_histogram_[b].load(std::memory_order::relaxed);
+    }
+    return stats;
+  }
+
+  // Returns the nanoseconds passed since `start`
+  static uint64_t elapsed_ns(std::chrono::steady_clock::time_point start) noexcept
+  {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start
+    ).count());
+  }
+
+private:
+  // Only the holder writes, so a load and a store suffice
+  static void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) noexcept
+  {
+    counter.store(counter.load(std::memory_order::relaxed) + n, std::memory_order::relaxed);
+  }
+
+  static size_t bucket(uint64_t ns) noexcept
+  {
+    return std::min<size_t>(std::bit_width(ns), LOCK_HISTOGRAM_BUCKETS - 1);
+  }
+
+  Lock lock_;
+  std::atomic<uint64_t> acquisitions_{0};
+  std::atomic<uint64_t> contended_{0};
+  std::atomic<uint64_t> wait_ns_{0};
+  std::atomic<uint64_t> holds_{0};
+  std::atomic<uint64_t> hold_ns_{0};
+  std::array<std::atomic<uint64_t>, LOCK_HISTOGRAM_BUCKETS> wait_histogram_{};
+  std::array<std::atomic<uint64_t>, LOCK_HISTOGRAM_BUCKETS> hold_histogram_{};
+};
+
+template <typename Lock>
+inline constexpr bool is_profiled_lock_v = false;
+
+template <typename Lock>
+inline constexpr bool is_profiled_lock_v<ProfiledLock<Lock>> = true;
+
+#ifdef PARALLELLAUNCHER_LOCK_PROFILING
+/// @brief Lock of internal structures, profiled by the build option
+using InternalLock = ProfiledLock<std::mutex>;
+#else
+/// @brief Lock of internal structures
+using InternalLock = std::mutex;
+#endif
@@ -0,0 +1,192 @@
+/**
+ *  ===========================================================================
+ * /                             MemoryPressure                               /
+ * ===========================================================================
+ *     -- Throttling launches and suspending jobs under memory pressure --
+ *
+ * > MemoryPressure watches PSI triggers on /proc/pressure/memory. Under
+ *   pressure it stops admitting new jobs, and if memory keeps stalling it
+ *   suspends the newest running jobs with SIGSTOP until pressure clears,
+ *   rather than letting the OOM killer pick victims
+ *
+ * > Utilities aside from the class:-
+ *   (+) enum PRESSURE_LEVEL_ENM - normal (admit), throttle (admit nothing new)
+ *                                 or suspend (also stop the newest jobs)
+ *   (+) struct MemoryPressureConfig_t - Triggers, settle time and batch size
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor (<thread manager>[, <config>])
+ *              - Registers the triggers and starts the monitor thread.
+ *                Throws std::system_error where PSI is unavailable
+ *
+ *   (+) void track(pid_t pid) - Adds a running job; newer jobs are
+ *                               suspended first
+ *   (+) void untrack(pid_t pid) - Forgets a job, e.g. once it exited
+ *   (+) bool admitted() - Checks whether new jobs may be launched
+ *   (+) bool wait_admitted(std::stop_token stoken)
+ *              - Blocks until new jobs may be launched; false if a stop
+ *                was requested first
+ *   (+) void apply(PRESSURE_LEVEL_ENM level)
+ *              - Moves to `level` as the monitor does on PSI events; for
+ *                callers with pressure signals of their own
+ *   (+) PRESSURE_LEVEL_ENM level() - Returns the current level
+ *   (+) size_t suspended() - Returns the number of jobs currently stopped
+ *   (+) void shutdown() - Stops the monitor and resumes every job
+ *
+ * > Two triggers are registered: "some" stall of `throttle_stall` per
+ *   `window` throttles, "full" stall of `suspend_stall` per `window`
+ *   suspends `suspend_batch` more jobs each time it fires. The monitor
+ *   thread sleeps in poll() on both (POLLPRI) and on an eventfd for
+ *   shutdown; nothing polls the pressure files periodically.
+ * > PSI reports rising pressure only, so pressure counts as cleared after
+ *   `settle` without events; the level then steps down once per `settle`,
+ *   resuming every suspended job (oldest first) when leaving suspend.
+ * > Stopped jobs are resumed, and launches admitted again, once the monitor
+ *   ends: on shutdown, on a global stop request on the manager, on
+ *   destruction, or if the triggers fail. No job is left stopped. The
+ *   manager must outlive the instance.
+ * > The monitor thread belongs to the instance rather than the manager, so
+ *   a join() on the manager never waits for it. The constructor takes any
+ *   BasicThreadManager, of which only the global stop is used. The stop
+ *   callback is only registered once every descriptor is open, since it may
+ *   wake the monitor right away.
+ */
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/types.h>
+
+#include <Cancellation.hpp>
+#include <ThreadManager.hpp>
+
+
+/// @brief How hard memory pressure currently limits jobs
+enum class PRESSURE_LEVEL_ENM : uint8_t { normal, throttle, suspend };
+
+///  @brief Triggers and reactions of a MemoryPressure
+struct MemoryPressureConfig_t
+{
+  // "some" stall per window that stops admitting new jobs
+  std::chrono::microseconds throttle_stall = std::chrono::milliseconds(100);
+  // "full" stall per window that suspends running jobs
+  std::chrono::microseconds suspend_stall = std::chrono::milliseconds(100);
+  // PSI tracking window; unprivileged triggers need a multiple of 2s
+  std::chrono::microseconds window = std::chrono::seconds(2);
+  // Time without events after which the level steps down
+  std::chrono::milliseconds settle = std::chrono::seconds(5);
+  // Jobs suspended per "full" event
+  size_t suspend_batch = 1;
+  std::string path = "/proc/pressure/memory";
+};
+
+/// @brief Throttles and suspends jobs on PSI memory pressure
+class MemoryPressure
+{
+  // A tracked job, oldest first
+  struct Job_t
+  {
+    pid_t pid;
+    bool stopped;
+  };
+
+  // Stops the monitor on a global stop request
+  struct Waker_t
+  {
+    void operator() () const noexcept
+    {
+      pressure->wake();
+    }
+    MemoryPressure* pressure;
+  };
+
+public:
+  MemoryPressure(const MemoryPressure&) = delete;
+  MemoryPressure& operator= (const MemoryPressure&) = delete;
+  MemoryPressure(MemoryPressure&&) = delete;
+  MemoryPressure& operator= (MemoryPressure&&) = delete;
+
+  MemoryPressure() = delete;
+
+  /**
+   * Registers the PSI triggers and starts the monitor thread
+   *
+   * @param manager BasicThreadManager whose global stop ends the monitor
+   * @param config Triggers and reactions
+   */
+  template <typename Manager>
+  explicit MemoryPressure(Manager& manager, MemoryPressureConfig_t config = {})
+    : MemoryPressure(std::move(config), manager.global_token())
+  { }
+  ~MemoryPressure();
+
+  // Adds a running job; newer jobs are suspended first
+  void track(pid_t pid);
+  // Forgets a job
+  void untrack(pid_t pid);
+
+  // Checks whether new jobs may be launched
+  bool admitted() const noexcept
+  {
+    return level_.load(std::memory_order::acquire) == PRESSURE_LEVEL_ENM::normal;
+  }
+
+  // Blocks until new jobs may be launched; false if stopped first
+  bool wait_admitted(std::stop_token stoken);
+
+  // Moves to `level`; suspend stops another batch each time
+  void apply(PRESSURE_LEVEL_ENM level);
+
+  PRESSURE_LEVEL_ENM level() const noexcept
+  {
+    return level_.load(std::memory_order::acquire);
+  }
+
+  // Returns the number of jobs currently stopped
+  size_t suspended();
+
+  // Stops the monitor and resumes every job
+  void shutdown() noexcept;
+
+private:
+  // Opens the triggers and the wake-up eventfd, then starts the monitor
+  MemoryPressure(MemoryPressureConfig_t config, CancellationToken global);
+
+  // Polls the triggers until stopped, then lets shutdown() return
+  void monitor(CancellationToken global);
+  // Sends SIGCONT to every stopped job; caller holds mtx_
+  void resume_all() noexcept;
+  // Wakes the monitor through wake_fd_
+  void wake() noexcept;
+
+  MemoryPressureConfig_t config_;
+  int some_fd_ = -1;
+  int full_fd_ = -1;
+  int wake_fd_ = -1;
+  std::atomic<PRESSURE_LEVEL_ENM> level_{PRESSURE_LEVEL_ENM::normal};
+  std::atomic<bool> stopping_{false};
+
+  // Guards everything below
+  std::mutex mtx_;
+  std::condition_variable_any level_cv_;
+  std::vector<Job_t> jobs_;
+  bool monitor_running_ = false;
+
+  // Empty until the descriptors it wakes through are open
+  std::optional<CancellationCallback<Waker_t>> stop_callback_;
+  std::jthread monitor_thread_;
+};
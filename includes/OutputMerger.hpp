@@ -0,0 +1,186 @@
+/**
+ *  ===========================================================================
+ * /                             OutputMerger                                 /
+ * ===========================================================================
+ *        -- A class to merge the output of many jobs into one stream --
+ *
+ * > OutputMerger interleaves output from many sources (jobs) into a single
+ *   file descriptor without tearing lines, optionally prefixing every line
+ *   with the tag of its source
+ *
+ * > Utilities aside from the class:-
+ *   (+) struct OutputMode_t - Selects tagging and line buffering (mirrors the
+ *                             --tag and --line-buffer options)
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor (<fd>[, <mode>][, <batch bytes>][, <flush interval>])
+ *
+ *   (+) uint32_t add_source(<tag>) - Registers a source, returns its id
+ *   (+) void write(<source>, <data>, <length>) - Feeds raw output of a source
+ *   (+) void close_source(<source>) - Emits whatever the source still holds
+ *                                     (a trailing partial line is terminated)
+ *   (+) void flush() - Writes out the pending batch
+ *
+ *   (+) uint64_t syscalls() - Number of writev calls issued so far
+ *   (+) uint64_t bytes_written() - Number of bytes written so far
+ *
+ * > In line buffered mode, whole lines are emitted as soon as they are
+ *   complete; otherwise the output of a source is held back until it is
+ *   closed, so each job's output stays grouped.
+ * > Emitted lines are not written one by one; they are coalesced into a batch
+ *   which is handed to writev once a write() makes it reach `batch bytes` or
+ *   IOV_MAX entries, or it is older than `flush interval`. The age is checked on every write,
+ *   and by a flusher thread sleeping until the batch is due, so the last
+ *   lines of a quiet source are not held back indefinitely.
+ * > Should writev fail midway, the bytes already written are dropped from
+ *   the batch and the error is thrown; a later flush resumes after them.
+ *   Output is moved into the batch before it is flushed, so a failing
+ *   write() or close_source() neither loses nor repeats any of it.
+ *   Errors met by the flusher thread are left for the next write or flush
+ *   to report.
+ * > OutputMerger is MT-safe; sources may be fed from different threads.
+ */
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/uio.h>
+
+
+///  @brief Output options of OutputMerger
+struct OutputMode_t
+{
+  // Prefix every line with "<tag>\t"
+  bool tag = false;
+  // Emit whole lines as they complete instead of grouping per source
+  bool line_buffer = false;
+};
+
+/// @brief Merges output of many sources into one descriptor in whole lines
+class OutputMerger
+{
+public:
+  OutputMerger(const OutputMerger&) = delete;
+  OutputMerger& operator= (const OutputMerger&) = delete;
+  OutputMerger(OutputMerger&&) = delete;
+  OutputMerger& operator= (OutputMerger&&) = delete;
+
+  OutputMerger() = delete;
+
+  /**
+   * Constructs an OutputMerger writing to `fd`
+   *
+   * @param fd Descriptor to write merged output to (not owned)
+   * @param mode Tagging and buffering options
+   * @param batch_bytes Size a batch may reach before it is written out
+   * @param flush_interval Age a non-empty batch may reach before it is
+   *                       written out
+   */
+  explicit OutputMerger(
+    int fd,
+    OutputMode_t mode = {},
+    size_t batch_bytes = 1UL << 16,
+    std::chrono::milliseconds flush_interval = std::chrono::milliseconds(100)
+  );
+  ~OutputMerger();
+
+  // Registers a new source with the given tag, returns its id
+  uint32_t add_source(std::string tag);
+
+  /**
+   * Feeds output produced by a source
+   *
+   * @param source Id returned by add_source()
+   * @param data Bytes produced by the source
+   * @param length Number of bytes
+   */
+  void write(uint32_t source, const char* data, size_t length);
+
+  void write(uint32_t source, std::string_view data)
+  {
+    write(source, data.data(), data.size());
+  }
+
+  // Emits the remaining output of `source` and releases its buffer
+  void close_source(uint32_t source);
+
+  // Writes out the pending batch
+  void flush();
+
+  // Returns the number of writev calls issued
+  uint64_t syscalls() const noexcept
+  {
+    return syscalls_.load(std::memory_order::relaxed);
+  }
+
+  // Returns the number of bytes written
+  uint64_t bytes_written() const noexcept
+  {
+    return bytes_written_.load(std::memory_order::relaxed);
+  }
+
+private:
+  struct Source_t
+  {
+    // "<tag>\t", or empty when tagging is disabled
+    std::string prefix;
+    // Output not yet moved into the batch
+    std::string pending;
+    bool open;
+  };
+
+  // One emitted chunk: the prefix of `source` followed by a slice of the
+  // arena
+  struct Piece_t
+  {
+    uint32_t source;
+    size_t offset;
+    size_t length;
+  };
+
+  // Magic number: Source of pieces written without a prefix
+  static constexpr uint32_t RAW_PIECE = UINT32_MAX;
+
+  // Appends the whole lines in `data` (all of it when `all` is set), then
+  // flushes if the batch is full
+  void emit(Source_t& source, std::string_view data, bool all);
+  void flush_locked();
+  // Replaces the batch with the `iovcnt` entries of `iov` not yet written
+  void keep_unwritten(const struct iovec* iov, int iovcnt);
+  // Flushes batches that reached their age until stopped
+  void flush_due(std::stop_token stoken);
+  Source_t& lookup(uint32_t source);
+
+  int fd_;
+  OutputMode_t mode_;
+  size_t batch_bytes_;
+  std::chrono::milliseconds flush_interval_;
+
+  std::vector<Source_t> sources_;
+  // Bytes of the current batch; referenced by offset so it may grow freely
+  std::string arena_;
+  std::vector<Piece_t> pieces_;
+  std::vector<struct iovec> iov_;
+  std::chrono::steady_clock::time_point batch_started_;
+
+  std::atomic<uint64_t> syscalls_{0};
+  std::atomic<uint64_t> bytes_written_{0};
+  std::mutex mtx_;
+  // Wakes the flusher once a batch starts
+  std::condition_variable_any batch_cv_;
+  // Started last, stopped first
+  std::jthread flusher_;
+};
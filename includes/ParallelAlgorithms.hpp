@@ -0,0 +1,483 @@
+/**
+ *  ===========================================================================
+ * /                          ParallelAlgorithms                              /
+ * ===========================================================================
+ *      -- Data-parallel loops, reductions and sorts on managed threads --
+ *
+ * > ParallelAlgorithms provides parallel_for, parallel_reduce and
+ *   parallel_sort, which split a range over the calling thread and helper
+ *   threads spawned through a ThreadManager (any BasicThreadManager whose
+ *   lock policy allows calls from several threads)
+ *
+ * > Utilities:-
+ *   (+) struct ParallelOptions_t - Grain size and thread count
+ *
+ *   (+) bool parallel_for(<manager>, <first>, <last>, <body>[, <options>])
+ *              - Calls body(begin, end) on disjoint sub-ranges covering
+ *                [first, last), or body(i) for each index if `body` takes a
+ *                single index. Returns false if cancelled
+ *   (+) std::optional<T> parallel_reduce(<manager>, <first>, <last>,
+ *                                        <identity>, <range op>, <combine>
+ *                                        [, <options>])
+ *              - Folds each sub-range with range_op(begin, end, init) and
+ *                combines the partial results with combine(a, b), which must
+ *                be associative and commutative. Returns std::nullopt if
+ *                cancelled
+ *   (+) bool parallel_sort(<manager>, <first>, <last>[, <compare>]
+ *                          [, <options>])
+ *              - Sorts chunks in parallel, then merges them pairwise in
+ *                parallel rounds. Returns false if cancelled, leaving the
+ *                range permuted but not sorted
+ *
+ * > Work is distributed by recursive range splitting with work stealing: each
+ *   participant starts with an equal share, keeps splitting the range it
+ *   holds until it reaches the grain size and pushes the upper halves onto
+ *   its own deque. Idle participants steal the oldest (largest) entries from
+ *   the other deques.
+ * > A global stop request on the manager cancels the algorithm between
+ *   grains, as does a local stop request to one of its helpers (that helper
+ *   leaves and its work is stolen by the others).
+ * > Exceptions thrown by the body cancel the remaining work and are rethrown
+ *   on the calling thread.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+#include <ThreadManager.hpp>
+
+
+///  @brief Tuning of the parallel algorithms
+struct ParallelOptions_t
+{
+  // Smallest range handed to the body; 0 picks one based on the range size
+  size_t grain = 0;
+  // Participating threads including the caller; 0 picks the number of CPUs
+  unsigned threads = 0;
+};
+
+namespace parallel_detail
+{
+  /// @brief Splits [first, last) over participants with work stealing
+  template <typename Index>
+  class RangeScheduler
+  {
+    using Range_t = std::pair<Index, Index>;
+
+    // Deque of ranges owned by one participant
+    struct Queue_t
+    {
+      std::mutex mtx;
+      std::deque<Range_t> ranges;
+    };
+
+  public:
+    RangeScheduler(Index first, Index last, size_t grain, unsigned participants)
+      : grain_(grain), queues_(participants), remaining_(last - first)
+    {
+      size_t size = static_cast<size_t>(last - first);
+      size_t share = size / participants;
+      Index begin = first;
+      for (unsigned p = 0; p < participants; p++)
+      {
+        Index end = (p + 1 == participants)
+          ? last
+          : begin + static_cast<Index>(share);
+        if (begin != end)
+        {
+          queues_[p].ranges.emplace_back(begin, end);
+        }
+        begin = end;
+      }
+    }
+
+    /**
+     * Runs grains as participant `self` until every element was processed or
+     * the run was cancelled
+     *
+     * @param self Index of the participant
+     * @param chunk Callable run for every grain as chunk(self, begin, end)
+     * @param cancel Callable checked before every grain; cancels the run
+     * @param leave Callable checked before every grain; only this
+     *              participant stops, its deque is left to the others
+     */
+    template <typename Chunk, typename Cancel, typename Leave>
+    void run(unsigned self, Chunk&& chunk, Cancel&& cancel, Leave&& leave)
+    {
+      Range_t range;
+      while (remaining_.load(std::memory_order::acquire) != 0)
+      {
+        if (cancelled_.load(std::memory_order::relaxed) || cancel())
+        {
+          cancelled_.store(true, std::memory_order::relaxed);
+          return;
+        }
+        if (leave())
+        {
+          return;
+        }
+        if (!pop(self, range) && !steal(self, range))
+        {
+          std::this_thread::yield();
+          continue;
+        }
+
+        // Split down to the grain, leaving upper halves for thieves
+        while (static_cast<size_t>(range.second - range.first) > grain_)
+        {
+          Index mid = range.first + (range.second - range.first) / 2;
+          push(self, {mid, range.second});
+          range.second = mid;
+        }
+
+        try
+        {
+          chunk(self, range.first, range.second);
+        }
+        catch (...)
+        {
+          std::lock_guard lock(error_mtx_);
+          if (!error_)
+          {
+            error_ = std::current_exception();
+          }
+          cancelled_.store(true, std::memory_order::relaxed);
+          return;
+        }
+        remaining_.fetch_sub(
+          static_cast<size_t>(range.second - range.first),
+          std::memory_order::acq_rel
+        );
+      }
+    }
+
+    bool cancelled() const noexcept
+    {
+      return cancelled_.load(std::memory_order::relaxed);
+    }
+
+    // Rethrows the first exception thrown by a grain, if any
+    void rethrow()
+    {
+      if (error_)
+      {
+        std::rethrow_exception(error_);
+      }
+    }
+
+  private:
+    void push(unsigned self, Range_t range)
+    {
+      std::lock_guard lock(queues_[self].mtx);
+      queues_[self].ranges.push_back(range);
+    }
+
+    // Takes the newest range of the own deque
+    bool pop(unsigned self, Range_t& range)
+    {
+      std::lock_guard lock(queues_[self].mtx);
+      if (queues_[self].ranges.empty())
+      {
+        return false;
+      }
+      range = queues_[self].ranges.back();
+      queues_[self].ranges.pop_back();
+      return true;
+    }
+
+    // Takes the oldest range of another participant's deque
+    bool steal(unsigned self, Range_t& range)
+    {
+      size_t n = queues_.size();
+      for (size_t i = 1; i < n; i++)
+      {
+        Queue_t& victim = queues_[(self + i) % n];
+        std::lock_guard lock(victim.mtx);
+        if (!victim.ranges.empty())
+        {
+          range = victim.ranges.front();
+          victim.ranges.pop_front();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    size_t grain_;
+    std::vector<Queue_t> queues_;
+    std::atomic<size_t> remaining_;
+    std::atomic<bool> cancelled_{false};
+    std::mutex error_mtx_;
+    std::exception_ptr error_;
+  };
+
+  // Resolves the number of participating threads
+  inline unsigned thread_count(const ParallelOptions_t& options) noexcept
+  {
+    return options.threads
+      ? options.threads
+      : std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  // Runs `chunk` over [first, last) on the caller and helper threads, as
+  // chunk(participant, begin, end) with participant < thread_count(options);
+  // returns false if cancelled
+  template <typename Manager, typename Index, typename Chunk>
+  bool run_parallel(
+    Manager& manager,
+    Index first,
+    Index last,
+    Chunk&& chunk,
+    ParallelOptions_t options
+  )
+  {
+    if (manager.stop_requested_all())
+    {
+      return false;
+    }
+    if (!(first < last))
+    {
+      return true;
+    }
+
+    size_t size = static_cast<size_t>(last - first);
+    unsigned threads = thread_count(options);
+    size_t grain = options.grain
+      ? options.grain
+      : std::max<size_t>(1, size / (8UL * threads));
+    unsigned participants = static_cast<unsigned>(
+      std::min<size_t>(threads, (size + grain - 1) / grain)
+    );
+
+    RangeScheduler<Index> scheduler(first, last, grain, participants);
+    auto global_stopped = [&manager] { return manager.stop_requested_all(); };
+
+    // Helpers that could not be spawned leave their share to be stolen
+    std::latch helpers_done(participants - 1);
+    unsigned spawned = 0;
+    try
+    {
+      for (unsigned p = 1; p < participants; p++)
+      {
+        manager.spawn_thread(
+          [&scheduler, &chunk, &helpers_done, p]
+          (std::stop_token local, CancellationToken global) {
+            scheduler.run(
+              p,
+              chunk,
+              [&global] { return global.stop_requested(); },
+              [&local] { return local.stop_requested(); }
+            );
+            helpers_done.count_down();
+          }
+        );
+        ++spawned;
+      }
+    }
+    catch (...)
+    {
+      helpers_done.count_down(participants - 1 - spawned);
+    }
+
+    scheduler.run(0, chunk, global_stopped, [] { return false; });
+    helpers_done.wait();
+
+    scheduler.rethrow();
+    return !scheduler.cancelled();
+  }
+}
+
+/**
+ * Runs `body` over [first, last) in parallel
+ *
+ * @param manager BasicThreadManager spawning the helper threads
+ * @param first Start of the index range
+ * @param last End of the index range (exclusive)
+ * @param body Callable taking (begin, end) or a single index
+ * @param options Grain size and thread count
+ * @returns True if the whole range was processed, false if cancelled
+ */
+template <typename Manager, typename Index, typename Body>
+bool parallel_for(
+  Manager& manager,
+  Index first,
+  Index last,
+  Body&& body,
+  ParallelOptions_t options = {}
+)
+{
+  static_assert(std::is_integral_v<Index>, "parallel_for needs an integral index");
+
+  return parallel_detail::run_parallel(
+    manager,
+    first,
+    last,
+    [&body] (unsigned, Index begin, Index end) {
+      if constexpr (std::is_invocable_v<Body&, Index, Index>)
+      {
+        body(begin, end);
+      }
+      else
+      {
+        for (Index i = begin; i < end; ++i)
+        {
+          body(i);
+        }
+      }
+    },
+    options
+  );
+}
+
+/**
+ * Reduces [first, last) in parallel
+ *
+ * @param manager BasicThreadManager spawning the helper threads
+ * @param first Start of the index range
+ * @param last End of the index range (exclusive)
+ * @param identity Identity element of `combine`
+ * @param range_op Callable folding a sub-range: range_op(begin, end, init)
+ * @param combine Associative and commutative callable merging two partials
+ * @param options Grain size and thread count
+ * @returns The reduction, or std::nullopt if cancelled
+ */
+template <
+  typename Manager,
+  typename Index,
+  typename T,
+  typename RangeOp,
+  typename Combine
+>
+std::optional<T> parallel_reduce(
+  Manager& manager,
+  Index first,
+  Index last,
+  T identity,
+  RangeOp&& range_op,
+  Combine&& combine,
+  ParallelOptions_t options = {}
+)
+{
+  static_assert(std::is_integral_v<Index>, "parallel_reduce needs an integral index");
+
+  // One partial per participant, each on its own cache line; grains of a
+  // participant fold into its partial in place
+  struct alignas(64) Partial_t
+  {
+    T value;
+  };
+  std::vector<Partial_t> partials(
+    parallel_detail::thread_count(options),
+    Partial_t{identity}
+  );
+
+  bool completed = parallel_detail::run_parallel(
+    manager,
+    first,
+    last,
+    [&] (unsigned participant, Index begin, Index end) {
+      T& partial = partials[participant].value;
+      partial = range_op(begin, end, std::move(partial));
+    },
+    options
+  );
+
+  if (!completed)
+  {
+    return std::nullopt;
+  }
+
+  T result = std::move(identity);
+  for (auto& partial : partials)
+  {
+    result = combine(std::move(result), std::move(partial.value));
+  }
+  return result;
+}
+
+/**
+ * Sorts [first, last) in parallel
+ *
+ * @param manager BasicThreadManager spawning the helper threads
+ * @param first Start of the range
+ * @param last End of the range
+ * @param compare Strict weak ordering
+ * @param options Smallest chunk sorted sequentially and thread count
+ * @returns True if the range is sorted, false if cancelled
+ */
+template <typename Manager, typename RandomIt, typename Compare = std::less<>>
+bool parallel_sort(
+  Manager& manager,
+  RandomIt first,
+  RandomIt last,
+  Compare compare = {},
+  ParallelOptions_t options = {}
+)
+{
+  size_t size = static_cast<size_t>(std::distance(first, last));
+  unsigned threads = parallel_detail::thread_count(options);
+  size_t min_chunk = options.grain ? options.grain : 4096UL;
+
+  if (manager.stop_requested_all())
+  {
+    return false;
+  }
+  if (threads == 1 || size <= min_chunk)
+  {
+    std::sort(first, last, compare);
+    return true;
+  }
+
+  // One chunk per thread (rounded to a power of two), merged pairwise
+  size_t chunks = std::bit_ceil(
+    std::min<size_t>(threads, (size + min_chunk - 1) / min_chunk)
+  );
+  size_t chunk_size = (size + chunks - 1) / chunks;
+  auto chunk_at = [&] (size_t c) {
+    return first + static_cast<std::ptrdiff_t>(std::min(size, c * chunk_size));
+  };
+
+  ParallelOptions_t chunk_options{1, threads};
+  if (!parallel_for(manager, size_t{0}, chunks, [&] (size_t c) {
+    std::sort(chunk_at(c), chunk_at(c + 1), compare);
+  }, chunk_options))
+  {
+    return false;
+  }
+
+  for (size_t width = 1; width < chunks; width *= 2)
+  {
+    if (!parallel_for(manager, size_t{0}, chunks / (2 * width), [&] (size_t pair) {
+      size_t left = pair * 2 * width;
+      std::inplace_merge(
+        chunk_at(left),
+        chunk_at(left + width),
+        chunk_at(left + 2 * width),
+        compare
+      );
+    }, chunk_options))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
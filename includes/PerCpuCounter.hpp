@@ -0,0 +1,179 @@
+/**
+ *  ===========================================================================
+ * /                             PerCpuCounter                                /
+ * ===========================================================================
+ *          -- A sharded counter that avoids cross-CPU cache traffic --
+ *
+ * > PerCpuCounter spreads a counter over cache-line-padded slots so that
+ *   concurrent updates from different CPUs never touch the same cache line
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor ([<slots>]) - Number of slots, rounded up to a power of
+ *                                 two; defaults to the number of CPUs
+ *
+ *   (+) void add(int64_t n) - Adds `n` to the slot of the current CPU
+ *   (+) void sub(int64_t n) - Subtracts `n` from the slot of the current CPU
+ *   (+) int64_t load() - Returns the total over all slots
+ *   (+) size_t slots() - Returns the number of slots
+ *
+ * > Slots are picked by the CPU number published by the kernel in the rseq
+ *   area glibc registers for every thread (one TLS load, no syscall). Where
+ *   rseq is unavailable, each thread is assigned a slot round-robin on first
+ *   use instead.
+ * > Updates stay atomic read-modify-writes, since a thread may migrate
+ *   between picking a slot and updating it. Such updates are rare and land
+ *   on a line that is almost always already owned by the local CPU.
+ * > Every update lands on exactly one slot, and load() is exact: it sums the
+ *   slots, then re-reads them and retries if any changed meanwhile, so the
+ *   total it returns was the value of the counter at one instant between the
+ *   two passes. Each slot packs its value with a tag that every update
+ *   bumps, hence an update that leaves the value unchanged is still noticed.
+ *   Updates stay a single read-modify-write; load() is lock-free (it only
+ *   retries while updates keep landing) and costs at least two cache misses
+ *   per slot, so it belongs on the slow path.
+ * > A slot holds values in [-2^39, 2^39), and load() could only miss changes
+ *   if 2^24 updates landed between its two passes.
+ */
+
+#pragma once
+
+
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <new>
+#include <thread>
+
+#include <cstddef>
+#include <cstdint>
+
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#define PARALLELLAUNCHER_HAS_RSEQ 1
+#endif
+
+
+/// @brief Counter sharded over per-CPU, cache-line-padded slots
+class PerCpuCounter
+{
+  // Magic number: Assumed size of a cache line (avoids the ABI warning
+  // attached to std::hardware_destructive_interference_size)
+  static constexpr size_t CACHE_LINE = 64UL;
+
+  // Magic number: Low bits of a slot holding its value; the rest count
+  // updates
+  static constexpr unsigned VALUE_BITS = 40U;
+  static constexpr uint64_t UPDATE_TAG = 1ULL << VALUE_BITS;
+
+  struct alignas(CACHE_LINE) Slot_t
+  {
+    std::atomic<uint64_t> word{0};
+  };
+
+public:
+  PerCpuCounter(const PerCpuCounter&) = delete;
+  PerCpuCounter& operator= (const PerCpuCounter&) = delete;
+  PerCpuCounter(PerCpuCounter&&) = delete;
+  PerCpuCounter& operator= (PerCpuCounter&&) = delete;
+
+  /**
+   * Constructs a zeroed counter
+   *
+   * @param slots Number of slots (rounded up to a power of two); 0 picks the
+   *              number of CPUs
+   */
+  explicit PerCpuCounter(size_t slots = 0)
+  {
+    if (slots == 0)
+    {
+      slots = std::thread::hardware_concurrency();
+    }
+    slots = std::bit_ceil(slots ? slots : 1UL);
+    mask_ = slots - 1;
+    slots_ = std::make_unique<Slot_t[]>(slots);
+  }
+
+  // Adds `n` to the slot of the current CPU
+  void add(int64_t n = 1) noexcept
+  {
+    slots_[slot_index() & mask_].word.fetch_add(
+      UPDATE_TAG + static_cast<uint64_t>(n), std::memory_order::seq_cst
+    );
+  }
+
+  // Subtracts `n` from the slot of the current CPU
+  void sub(int64_t n = 1) noexcept
+  {
+    slots_[slot_index() & mask_].word.fetch_add(
+      UPDATE_TAG - static_cast<uint64_t>(n), std::memory_order::seq_cst
+    );
+  }
+
+  // Returns the total over all slots
+  int64_t load() const noexcept
+  {
+    for (;;)
+    {
+      // Every update changes the sum of the raw words, so equal sums mean
+      // no slot changed between the passes
+      uint64_t words = 0;
+      int64_t total = 0;
+      for (size_t i = 0; i <= mask_; i++)
+      {
+        uint64_t word = slots_[i].word.load(std::memory_order::seq_cst);
+        words += word;
+        total += value_of(word);
+      }
+
+      uint64_t recheck = 0;
+      for (size_t i = 0; i <= mask_; i++)
+      {
+        recheck += slots_[i].word.load(std::memory_order::seq_cst);
+      }
+      if (recheck == words)
+      {
+        return total;
+      }
+    }
+  }
+
+  // Returns the number of slots
+  size_t slots() const noexcept
+  {
+    return mask_ + 1;
+  }
+
+  // Returns the slot hint of the calling thread (CPU number where known)
+  static uint32_t slot_index() noexcept
+  {
+#ifdef PARALLELLAUNCHER_HAS_RSEQ
+    if (__rseq_size != 0) [[likely]]
+    {
+      const auto* area = reinterpret_cast<const volatile struct rseq*>(
+        static_cast<const char*>(__builtin_thread_pointer()) + __rseq_offset
+      );
+      return area->cpu_id;
+    }
+#endif
+    return thread_slot();
+  }
+
+private:
+  // Sign-extends the value bits of a slot
+  static int64_t value_of(uint64_t word) noexcept
+  {
+    return static_cast<int64_t>(word << (64U - VALUE_BITS)) >> (64U - VALUE_BITS);
+  }
+
+  // Per-thread fallback: threads are spread round-robin over the slots
+  static uint32_t thread_slot() noexcept
+  {
+    static std::atomic<uint32_t> next_slot{0};
+    thread_local const uint32_t slot =
+      next_slot.fetch_add(1, std::memory_order::relaxed);
+    return slot;
+  }
+
+  std::unique_ptr<Slot_t[]> slots_;
+  size_t mask_;
+};
@@ -0,0 +1,63 @@
+/**
+ *  ===========================================================================
+ * /                                 Probes                                   /
+ * ===========================================================================
+ *          -- USDT static probes on the library's hot paths --
+ *
+ * > PARALLELLAUNCHER_PROBE(name, args...) marks a USDT probe point of the
+ *   `parallellauncher` provider, which bpftrace, perf and SystemTap can
+ *   attach to (refer scripts/bpftrace)
+ *
+ * > Utilities:-
+ *   (+) PARALLELLAUNCHER_PROBE(name[, args...]) - Probe point; at most 12
+ *                                                 integer or pointer args
+ *   (+) uint64_t probe_key(const std::thread::id& tid) - Integer identifying
+ *                                                        a thread in probes
+ *
+ * > Probes (arguments in order):-
+ *   (+) spawn__start(manager), spawn__done(manager, thread key)
+ *   (+) worker__start(manager, thread key), worker__exit(manager, thread key)
+ *   (+) worker__stall(manager, thread key)
+ *   (+) worker__restart(manager, thread key)
+ *   (+) stop__request(manager, thread key, requested)
+ *   (+) stop__request__all(manager)
+ *   (+) join__start(manager, threads), join__done(manager, threads)
+ *   (+) signal__enter(sig), signal__exit(sig, subscribers notified)
+ *
+ * > A probe point compiles to a single nop plus an ELF note; nothing is
+ *   linked at runtime and nothing runs unless a tracer attaches. sys/sdt.h
+ *   only provides macros and is picked up when found (e.g. from
+ *   systemtap-sdt-dev); without it, or with PARALLELLAUNCHER_NO_PROBES
+ *   defined, probe points compile away.
+ * > Arguments are only evaluated for their values, so they must be cheap and
+ *   free of side effects.
+ */
+
+#pragma once
+
+
+#include <functional>
+#include <thread>
+
+#include <cstdint>
+
+#if !defined(PARALLELLAUNCHER_NO_PROBES) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PARALLELLAUNCHER_PROBE(name, ...) \
+  STAP_PROBEV(parallellauncher, name, ##__VA_ARGS__)
+#else
+#define PARALLELLAUNCHER_PROBE(name, ...) do { } while (0)
+#endif
+
+
+/**
+ * Returns an integer identifying `tid` in probe arguments; equal to the
+ * thread's pthread_t with libstdc++
+ *
+ * @param tid Thread to identify
+ * @returns The key of the thread
+ */
+inline uint64_t probe_key(const std::thread::id& tid) noexcept
+{
+  return static_cast<uint64_t>(std::hash<std::thread::id>{}(tid));
+}
@@ -0,0 +1,138 @@
+/**
+ *  ===========================================================================
+ * /                             SharedInputs                                 /
+ * ===========================================================================
+ *       -- A class to share read-only job inputs across child processes --
+ *
+ * > SharedInputs loads named inputs exactly once into sealed memfds so that
+ *   every child can map the same pages instead of re-opening and re-reading
+ *   the source file
+ *
+ * > The class has the following public methods:-
+ *   (+) int add(<name>, <path>) - Loads the file at `path` into a sealed
+ *                                 memfd registered as `name`. Throws if
+ *                                 `name` is taken or maps to the same
+ *                                 variable as another input (see below)
+ *   (+) int add_buffer(<name>, <data>, <size>) - Same as above, but from an
+ *                                                in-memory buffer
+ *
+ *   (+) int fd(<name>) (throws for unknown names) - Returns the memfd
+ *   (+) size_t size(<name>) (throws for unknown names) - Returns the size
+ *   (+) std::string proc_path(<name>) (throws for unknown names)
+ *              - Returns "/proc/self/fd/N", which stays valid inside children
+ *                since inherited descriptors keep their numbers
+ *   (+) std::vector<std::string> environment()
+ *              - Returns one "PL_SHARED_<NAME>=/proc/self/fd/N" entry per
+ *                input, suitable for a child's environment. <NAME> is the
+ *                name upper-cased, with every other character than letters
+ *                and digits replaced by '_'
+ *
+ *   (+) void prepare_child() - Clears FD_CLOEXEC on every memfd. Is
+ *                              async-signal-safe and meant to be called in the
+ *                              child between fork and exec
+ *   (+) size_t count() - Returns the number of registered inputs
+ *
+ * > Every memfd carries F_SEAL_WRITE, F_SEAL_SHRINK, F_SEAL_GROW and
+ *   F_SEAL_SEAL, hence children can mmap it PROT_READ with MAP_SHARED (zero
+ *   copies) and rely on the contents never changing underneath them.
+ * > Descriptors stay FD_CLOEXEC in the parent, so only children that go
+ *   through prepare_child() inherit them.
+ * > SharedInputs is not MT-safe for concurrent add() calls; register inputs
+ *   before launching jobs.
+ */
+
+#pragma once
+
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cstddef>
+
+
+/// @brief Loads named read-only inputs into sealed memfds for child processes
+class SharedInputs
+{
+public:
+  SharedInputs(const SharedInputs&) = delete;
+  SharedInputs& operator= (const SharedInputs&) = delete;
+  SharedInputs(SharedInputs&&) = delete;
+  SharedInputs& operator= (SharedInputs&&) = delete;
+
+  SharedInputs() = default;
+  ~SharedInputs();
+
+  /**
+   * Loads the file at `path` into a new sealed memfd
+   *
+   * @param name Name to register the input as (must be unique, also once
+   *             mapped to its environment variable)
+   * @param path Path of the file to load
+   * @returns The sealed memfd
+   */
+  int add(const std::string& name, const std::string& path);
+
+  /**
+   * Copies `size` bytes from `data` into a new sealed memfd
+   *
+   * @param name Name to register the input as (must be unique, also once
+   *             mapped to its environment variable)
+   * @param data Buffer to copy from
+   * @param size Number of bytes to copy
+   * @returns The sealed memfd
+   */
+  int add_buffer(const std::string& name, const void* data, size_t size);
+
+  // Returns the memfd of input `name`
+  int fd(const std::string& name) const
+  {
+    return lookup(name).fd;
+  }
+
+  // Returns the size in bytes of input `name`
+  size_t size(const std::string& name) const
+  {
+    return lookup(name).size;
+  }
+
+  // Returns the /proc/self/fd path of input `name`
+  std::string proc_path(const std::string& name) const
+  {
+    return "/proc/self/fd/" + std::to_string(lookup(name).fd);
+  }
+
+  // Returns environment entries advertising every input to a child
+  std::vector<std::string> environment() const;
+
+  // Makes every memfd inheritable across exec (async-signal-safe)
+  void prepare_child() const noexcept;
+
+  // Returns the number of registered inputs
+  size_t count() const noexcept
+  {
+    return inputs_.size();
+  }
+
+private:
+  struct Input_t
+  {
+    int fd;
+    size_t size;
+  };
+
+  // Creates an empty memfd registered as `name` with the given size
+  int create(const std::string& name, size_t size);
+  // Applies the read-only seals and registers the input; closes `memfd` on
+  // failure
+  int seal(const std::string& name, int memfd, size_t size);
+
+  const Input_t& lookup(const std::string& name) const;
+
+  std::unordered_map<std::string, Input_t, std::hash<std::string>> inputs_;
+  // Flat copy of the descriptors; walked by prepare_child() without touching
+  // the map
+  std::vector<int> fds_;
+  // Environment variable of every input, mapped to its name
+  std::unordered_map<std::string, std::string, std::hash<std::string>> env_keys_;
+};
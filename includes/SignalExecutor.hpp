@@ -0,0 +1,335 @@
+/**
+ *  ===========================================================================
+ * /                             SignalExecutor                               /
+ * ===========================================================================
+ *          -- Runs per-signal callbacks as tasks on an ElasticPool --
+ *
+ * > SignalExecutor subscribes to a set of signals and, whenever one arrives,
+ *   schedules the callback registered for it as a task on an ElasticPool
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor (<thread manager>, <pool>, <list of signals>[, <flags>])
+ *
+ *   (+) void on(int sig, <callback>) - Registers `callback(sig)` for `sig`,
+ *                                      replacing any previous one. Throws
+ *                                      std::invalid_argument if `sig` is not
+ *                                      in the list
+ *   (+) void shutdown() - Stops scheduling and waits for scheduled callbacks
+ *   (+) uint64_t coalesced() - Returns the number of arrivals merged into an
+ *                              already scheduled run
+ *
+ * > The signal handler itself only sets the signal's pending bit and bumps
+ *   the subscriber's eventfd (refer SignalHandler). A single waiter thread,
+ *   spawned through the ThreadManager, sleeps on that eventfd and turns the
+ *   pending bits into tasks; no thread polls.
+ * > Repeated signals coalesce: while a callback is queued, further arrivals
+ *   of its signal are merged into it; while it runs, they make it run once
+ *   more after it returns. A callback therefore never runs concurrently with
+ *   itself, and runs at least once after the last arrival.
+ * > A callback escaping with an exception terminates the process, like any
+ *   ElasticPool task.
+ * > The pool and the manager must outlive the executor. A global stop request
+ *   on the manager stops the waiter; scheduled callbacks are then dropped
+ *   along with the pool's queue.
+ * > SignalExecutor is an alias of BasicSignalExecutor over ThreadManager; a
+ *   BasicSignalExecutor<M> runs over any BasicThreadManager M whose lock
+ *   policy allows calls from several threads, with a BasicElasticPool<M>.
+ */
+
+#pragma once
+
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <Cancellation.hpp>
+#include <ElasticPool.hpp>
+#include <SignalHandler.hpp>
+#include <ThreadManager.hpp>
+
+
+/// @brief Schedules per-signal callbacks on a BasicElasticPool
+template <typename Manager = ThreadManager>
+class BasicSignalExecutor
+{
+  enum RUN_STATE_ENM : uint8_t { idle, queued, running, rerun };
+
+  // Accounts for a scheduled callback, also when the pool drops it unrun
+  struct Ticket_t
+  {
+    Ticket_t(BasicSignalExecutor* owner, int sig) noexcept
+      : owner(owner), sig(sig)
+    { }
+    Ticket_t(Ticket_t&& other) noexcept
+      : owner(std::exchange(other.owner, nullptr)), sig(other.sig), ran(other.ran)
+    { }
+    Ticket_t(const Ticket_t&) = delete;
+    ~Ticket_t()
+    {
+      if (owner)
+      {
+        owner->retire(sig, ran);
+      }
+    }
+
+    BasicSignalExecutor* owner;
+    int sig;
+    bool ran = false;
+  };
+
+  // Wakes the waiter on a global stop request
+  struct Waker_t
+  {
+    void operator() () const noexcept
+    {
+      executor->wake();
+    }
+    BasicSignalExecutor* executor;
+  };
+
+public:
+  BasicSignalExecutor(const BasicSignalExecutor&) = delete;
+  BasicSignalExecutor& operator= (const BasicSignalExecutor&) = delete;
+  BasicSignalExecutor(BasicSignalExecutor&&) = delete;
+  BasicSignalExecutor& operator= (BasicSignalExecutor&&) = delete;
+
+  BasicSignalExecutor() = delete;
+
+  /**
+   * Subscribes to `signal_list` and starts the waiter thread
+   *
+   * @param manager Manager spawning the waiter thread
+   * @param pool Pool running the callbacks
+   * @param signal_list Signals to handle
+   * @param flags Flags (refer to sigaction)
+   */
+  BasicSignalExecutor(
+    Manager& manager,
+    BasicElasticPool<Manager>& pool,
+    std::initializer_list<int> signal_list,
+    int flags = 0
+  ) : pool_(pool),
+      handler_(signal_list, flags),
+      event_fd_(handler_.event_fd()),
+      stop_callback_(manager.global_token(), Waker_t{this})
+  {
+    for (const int signal : signal_list)
+    {
+      handled_[signal] = true;
+    }
+
+    waiter_running_ = true;
+    try
+    {
+      manager.spawn_thread([this] (std::stop_token, CancellationToken global) {
+        wait_loop(global);
+
+        std::lock_guard lock(mtx_);
+        waiter_running_ = false;
+        done_cv_.notify_all();
+      });
+    }
+    catch (...)
+    {
+      waiter_running_ = false;
+      throw;
+    }
+  }
+
+  ~BasicSignalExecutor()
+  {
+    shutdown();
+  }
+
+  /**
+   * Registers `callback` for `sig`, replacing the previous one
+   *
+   * @param sig Signal the callback handles; must be in the constructor's list
+   * @param callback Invoked with `sig` on a pool worker
+   */
+  void on(int sig, std::function<void(int)> callback)
+  {
+    if (sig <= 0 || sig >= NSIG || !handled_[sig])
+    {
+      throw std::invalid_argument(
+        std::to_string(sig) + " is not handled by this SignalExecutor"
+      );
+    }
+    std::unique_lock lock(callbacks_mtx_);
+    callbacks_[sig] = std::move(callback);
+  }
+
+  // Stops scheduling callbacks and waits for the scheduled ones
+  void shutdown() noexcept
+  {
+    stopping_.store(true, std::memory_order::release);
+    wake();
+
+    std::unique_lock lock(mtx_);
+    done_cv_.wait(lock, [this] { return !waiter_running_ && scheduled_ == 0; });
+  }
+
+  // Returns the number of arrivals merged into an already scheduled run
+  uint64_t coalesced() const noexcept
+  {
+    return coalesced_.load(std::memory_order::relaxed);
+  }
+
+private:
+  // Turns pending signals into tasks until stopped
+  void wait_loop(CancellationToken global)
+  {
+    pollfd pfd{event_fd_, POLLIN, 0};
+    while (!stopping_.load(std::memory_order::acquire) && !global.stop_requested())
+    {
+      if (poll(&pfd, 1, -1) == -1 && errno != EINTR)
+      {
+        return;
+      }
+
+      uint64_t count;
+      [[maybe_unused]] ssize_t drained = read(event_fd_, &count, sizeof(count));
+
+      SignalMask_t pending;
+      if (!handler_.pop_all_signals(pending))
+      {
+        continue;
+      }
+      for (int sig = 1; sig < NSIG; sig++)
+      {
+        uint32_t word = sig < 32 ? pending.OS_sigs
+                      : sig < 64 ? pending.RT_sigs
+                      : pending.reserved;
+        if (word & signal_bitmask(sig))
+        {
+          schedule(sig);
+        }
+      }
+    }
+  }
+
+  // Queues a run of `sig`'s callback unless one is pending already
+  void schedule(int sig)
+  {
+    uint8_t state = states_[sig].load(std::memory_order::acquire);
+    for (;;)
+    {
+      if (state == RUN_STATE_ENM::queued || state == RUN_STATE_ENM::rerun)
+      {
+        coalesced_.fetch_add(1, std::memory_order::relaxed);
+        return;
+      }
+      uint8_t next = (state == RUN_STATE_ENM::idle)
+                   ? RUN_STATE_ENM::queued
+                   : RUN_STATE_ENM::rerun;
+      if (states_[sig].compare_exchange_weak(state, next, std::memory_order::acq_rel))
+      {
+        if (next == RUN_STATE_ENM::rerun)
+        {
+          return;
+        }
+        break;
+      }
+    }
+
+    {
+      std::lock_guard lock(mtx_);
+      ++scheduled_;
+    }
+    try
+    {
+      pool_.submit([ticket = Ticket_t(this, sig)] () mutable {
+        ticket.ran = true;
+        ticket.owner->run(ticket.sig);
+      });
+    }
+    catch (...)
+    {
+      // The ticket was destroyed unrun, which undid the above
+    }
+  }
+
+  // Runs `sig`'s callback, again for every rerun requested meanwhile
+  void run(int sig)
+  {
+    for (;;)
+    {
+      states_[sig].store(RUN_STATE_ENM::running, std::memory_order::release);
+      {
+        std::shared_lock lock(callbacks_mtx_);
+        if (callbacks_[sig])
+        {
+          callbacks_[sig](sig);
+        }
+      }
+
+      uint8_t expected = RUN_STATE_ENM::running;
+      if (states_[sig].compare_exchange_strong(
+        expected, RUN_STATE_ENM::idle, std::memory_order::acq_rel
+      ))
+      {
+        return;
+      }
+    }
+  }
+
+  // Releases a scheduled run; resets the state of runs dropped by the pool
+  void retire(int sig, bool ran) noexcept
+  {
+    if (!ran)
+    {
+      states_[sig].store(RUN_STATE_ENM::idle, std::memory_order::release);
+    }
+    std::lock_guard lock(mtx_);
+    if (--scheduled_ == 0)
+    {
+      done_cv_.notify_all();
+    }
+  }
+
+  // Wakes the waiter through the subscriber's eventfd
+  void wake() noexcept
+  {
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(event_fd_, &one, sizeof(one));
+  }
+
+  BasicElasticPool<Manager>& pool_;
+  SignalHandler handler_;
+  int event_fd_;
+
+  // Whether each signal is in the subscribed list; fixed after construction
+  bool handled_[NSIG] = {};
+  std::atomic<uint8_t> states_[NSIG] = {};
+  std::atomic<uint64_t> coalesced_{0};
+  std::atomic<bool> stopping_{false};
+
+  // Callbacks run under a shared lock, on() takes it exclusively
+  std::shared_mutex callbacks_mtx_;
+  std::function<void(int)> callbacks_[NSIG];
+
+  // Guards everything below
+  std::mutex mtx_;
+  std::condition_variable done_cv_;
+  size_t scheduled_ = 0;
+  bool waiter_running_ = false;
+
+  CancellationCallback<Waker_t> stop_callback_;
+};
+
+/// @brief SignalExecutor over a ThreadManager with the default policies
+using SignalExecutor = BasicSignalExecutor<>;
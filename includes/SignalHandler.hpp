@@ -9,6 +9,8 @@
  * > Utilities aside from the class:-
  *   (+) uint32_t sigbitmask(int) - Provides a bitmask for the given signal
  *   (+) struct SignalMask_t - Used to return information via the API functions
+ *   (+) class StaticSignalHandler<signals...> - SignalHandler with the set of
+ *                                               signals fixed at compile time
  * 
  * > The class has the following public methods:-
  *   (+) Constructor (<list of signals>[, <flags>][, <error switch>])
@@ -19,11 +21,31 @@
  *   (+) bool test_all_signals(SignalMask_t& sigbitmask) - Tests all signals
  *   (+) bool pop_all_signals(SignalMask_t& sigbitmask) - Same as above and
  *                                                        clears signal states
+ *   (+) int event_fd() - Returns an eventfd (created on first call) that is
+ *                        incremented whenever a registered signal is raised
+ * 
+ * > StaticSignalHandler<signals...> has the same methods, plus:-
+ *   (+) Constructor ([<flags>][, <error switch>])
+ *   (+) bool test_signal<sig>() - Tests a registered signal with a single load
+ *                                 against a constant mask
+ *   (+) bool pop_signal<sig>() - Same as above and clears signal state
+ *   (+) static constexpr SignalMask_t MASK - Bitmasks of the registered signals
+ *   The signals are validated by static_assert, hence construction does not
+ *   walk or check a signal list at run time. It allocates only when it is
+ *   the first subscriber in the process, which starts the shared dispatch
+ *   thread. Note that SIGRTMIN is not a constant expression in glibc; spell
+ *   RT signals as numbers.
  * 
  * > SignalHandler is MT-safe and converts an asynchronous signal experience to 
  *   synchronous.
- * > Only a single instance of SignalHandler can be instantiated at once, in a 
- *   process.
+ * > Every instance is a subscriber with its own interest mask and pending
+ *   signal states; any number of them (up to MAX_SUBSCRIBERS) may coexist.
+ *   They share one process wide installation: the action of a signal is
+ *   installed by its first subscriber (whose flags apply) and restored when
+ *   its last subscriber is destroyed. A single handler fans each signal out
+ *   to the interested subscribers, and a single dispatch thread serves all.
+ * > The shared handler fires the signal__enter and signal__exit USDT probes
+ *   (refer Probes.hpp).
  * > SignalHandler is designed to handle signals for the whole process
  * > Ideally, an instance should be created before any threads are created.
  *   SignalHandler internally relies on pthread_sigmask and sigaction to 
@@ -38,19 +60,24 @@
 #pragma once
 
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <stop_token>
 #include <stdexcept>
 #include <system_error>
 #include <thread>
-#include <unordered_map>
+#include <utility>
 
 #include <cerrno>
 #include <csignal>
 #include <cstdint>
 #include <cstring>
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 
 /** 
  * For the given signal, returns a uint32 bitmask shifted according to the
@@ -90,51 +117,39 @@ struct SignalMask_t
   uint32_t reserved;
 };
 
-/// @brief Allows registered signals to be handled and queried synchronously 
-///        per process
-class SignalHandler
+/// @brief Subscription state and queries shared by SignalHandler and
+///        StaticSignalHandler
+class SignalHandlerBase
 {
+protected:
   // Magic number: Size of signal bitmask array
   static constexpr size_t SIGFLAGN = 3UL;
   // Enum to index signal bitmask array
   enum SIG_FLAGS_ENM { OS_sigs, RT_sigs, reserved };
 
+  // Returns the index of the signal bitmask holding `sig`
+  static constexpr SIG_FLAGS_ENM flag_index(int sig) noexcept
+  {
+    if (sig >= 32 && sig < 64)
+    {
+      return SIG_FLAGS_ENM::RT_sigs;
+    }
+    // Path reserved for future expansion
+    if (sig >= 64) [[unlikely]]
+    {
+      return SIG_FLAGS_ENM::reserved;
+    }
+    return SIG_FLAGS_ENM::OS_sigs;
+  }
+
 public:
-  SignalHandler(const SignalHandler&) = delete;
-  SignalHandler& operator= (const SignalHandler&) = delete;
-  SignalHandler(SignalHandler&&) = delete;
-  SignalHandler& operator= (SignalHandler&&) = delete;
+  // Magic number: Subscriber slots scanned by the signal handler
+  static constexpr size_t MAX_SUBSCRIBERS = 64UL;
 
-  SignalHandler() = delete;
-
-  /**
-   * Constructs an instance of SignalHandler with the given set of signals and
-   * optional flags
-   * @param signal_list Set of signals to register
-   * @param flags Flags (refer to sigaction)
-   * @param throw_sig_error Throws errors (if any) while setting up handler for
-   *                        every signal when true, else skips faulty installs
-   */
-  SignalHandler(
-    std::initializer_list<int> signal_list, 
-    int flags = 0,
-    bool throw_sig_error = true
-  );
-
-  /**
-   * Constructs an instance of SignalHandler with the given set of signals and
-   * their respective flags
-   * 
-   * @param initialiser_list Pairs of signals to register and their respective 
-   *                         flags (refer sigaction)
-   * @param throw_sig_error Throws errors (if any) while setting up handler for
-   *                        every signal when true, else skips faulty installs
-   */
-  SignalHandler(
-    std::initializer_list<std::pair<int, int>> initialiser_list,
-    bool throw_sig_error = true
-  );
-  ~SignalHandler();
+  SignalHandlerBase(const SignalHandlerBase&) = delete;
+  SignalHandlerBase& operator= (const SignalHandlerBase&) = delete;
+  SignalHandlerBase(SignalHandlerBase&&) = delete;
+  SignalHandlerBase& operator= (SignalHandlerBase&&) = delete;
 
   /**
    * Tests whether a given signal was raised
@@ -150,18 +165,7 @@ public:
       return false;
     }
 
-    SIG_FLAGS_ENM flagenm = SIG_FLAGS_ENM::OS_sigs;
-    if (sig >= 32 && sig < 64)
-    {
-      flagenm = SIG_FLAGS_ENM::RT_sigs;
-    }
-    // Path reserved for future expansion
-    else if (sig >= 64) [[unlikely]]
-    {
-      flagenm = SIG_FLAGS_ENM::reserved;
-    }
-
-    return sig_flags_[flagenm].load(std::memory_order::acquire) &
+    return sig_flags_[flag_index(sig)].load(std::memory_order::acquire) &
            signal_bitmask(sig);
   }
 
@@ -203,21 +207,10 @@ public:
       return false;
     }
 
-    SIG_FLAGS_ENM flagenm = SIG_FLAGS_ENM::OS_sigs;
-    if (sig >= 32 && sig < 64)
-    {
-      flagenm = SIG_FLAGS_ENM::RT_sigs;
-    }
-    // Path reserved for future expansion
-    else if (sig >= 64) [[unlikely]]
-    {
-      flagenm = SIG_FLAGS_ENM::reserved;
-    }
-
-    return sig_flags_[flagenm].fetch_and(
+    return sig_flags_[flag_index(sig)].fetch_and(
       ~ signal_bitmask(sig), 
       std::memory_order::release
-    );
+    ) & signal_bitmask(sig);
   }
 
   /**
@@ -231,65 +224,219 @@ public:
    */
   bool pop_all_signals(SignalMask_t& sigbitmask) noexcept
   {
-    bool ret = test_all_signals(sigbitmask);
-    sig_flags_[SIG_FLAGS_ENM::OS_sigs].store(0, std::memory_order::release);
-    sig_flags_[SIG_FLAGS_ENM::RT_sigs].store(0, std::memory_order::release);
+    sigbitmask.OS_sigs = sig_flags_[SIG_FLAGS_ENM::OS_sigs]
+                                .exchange(0, std::memory_order::acq_rel);
+    sigbitmask.RT_sigs = sig_flags_[SIG_FLAGS_ENM::RT_sigs]
+                                .exchange(0, std::memory_order::acq_rel);
     // Reserved for future expansion
-    sig_flags_[SIG_FLAGS_ENM::reserved].store(0, std::memory_order::release);
-    return ret;
+    sigbitmask.reserved = sig_flags_[SIG_FLAGS_ENM::reserved]
+                                .exchange(0, std::memory_order::acq_rel);
+
+    return sigbitmask.OS_sigs ||
+           sigbitmask.RT_sigs ||
+           sigbitmask.reserved;
   }
 
+  /**
+   * Returns an eventfd counting the registered signals raised from now on,
+   * creating it on the first call. The descriptor is owned by the instance
+   * 
+   * @returns The non-blocking eventfd
+   */
+  int event_fd();
+
+protected:
+  SignalHandlerBase() noexcept;
+  // Unsubscribes, restoring actions whose last subscriber this was
+  ~SignalHandlerBase();
+
+  // Blocks sigmask_ for the calling thread (and threads it creates later)
+  void block_signals();
+
+  /**
+   * Installs the shared action of `sig` unless already installed, and adds
+   * `sig` to this instance's interest. Call before subscribe()
+   * 
+   * @param sig Signal to install, must be in sigmask_
+   * @param flags Flags (refer sigaction), used by the first subscriber only
+   * @returns False if sigaction failed (errno is set)
+   */
+  bool install(int sig, int flags);
+
+  // Publishes this instance to the signal handler; throws std::length_error
+  // if all MAX_SUBSCRIBERS slots are taken
+  void subscribe();
+
+  // Stores mask of the registered signals
+  sigset_t sigmask_;
+
+  // Signal states raised for this instance
+  std::atomic<uint32_t> sig_flags_[SIGFLAGN];
 
 private:
   // Callback to be installed as an action using sigaction
   static void handler_callback(int, siginfo_t*, void*) noexcept;
 
-  // Lambda used to create the dispatcher thread
-  static inline auto dispatcher = [] (
-    const std::stop_token& stoken,
-    std::mutex& dispatch_mtx_,
-    std::condition_variable& cv,
-    const sigset_t* sigmask_ptr
-  ) noexcept 
+  // Body of the shared dispatch thread
+  static void dispatcher(std::stop_token stoken) noexcept;
+
+  // Signals whose action this instance holds a reference to
+  sigset_t installed_;
+  // Bitmasks of the signals delivered to this instance
+  uint32_t interest_[SIGFLAGN] = {};
+  // Eventfd written on delivery, -1 if none
+  std::atomic<int> event_fd_{-1};
+  // Slot taken in subscribers_, MAX_SUBSCRIBERS if not subscribed
+  size_t slot_ = MAX_SUBSCRIBERS;
+
+  // Subscribers scanned by the handler
+  static std::atomic<SignalHandlerBase*> subscribers_[MAX_SUBSCRIBERS];
+  // Handlers currently scanning subscribers_
+  static std::atomic<uint32_t> in_flight_;
+
+  // Guards everything below and the dispatch thread's mask changes
+  static std::mutex registry_mtx_;
+  static std::condition_variable_any registry_cv_;
+  // Number of subscribers holding each signal's action
+  static uint32_t install_count_[NSIG];
+  // Actions to restore once a signal loses its last subscriber
+  static struct sigaction old_actions_[NSIG];
+  // Union of the installed signals, unblocked by the dispatch thread
+  static sigset_t dispatch_mask_;
+  // Bumped whenever dispatch_mask_ changes
+  static uint64_t dispatch_generation_;
+  static size_t subscriber_count_;
+  static std::jthread dispatch_thread_;
+};
+
+/// @brief Allows registered signals to be handled and queried synchronously 
+///        per process
+class SignalHandler : public SignalHandlerBase
+{
+public:
+  SignalHandler() = delete;
+
+  /**
+   * Constructs an instance of SignalHandler with the given set of signals and
+   * optional flags
+   * @param signal_list Set of signals to register
+   * @param flags Flags (refer to sigaction)
+   * @param throw_sig_error Throws errors (if any) while setting up handler for
+   *                        every signal when true, else skips faulty installs
+   */
+  SignalHandler(
+    std::initializer_list<int> signal_list, 
+    int flags = 0,
+    bool throw_sig_error = true
+  );
+
+  /**
+   * Constructs an instance of SignalHandler with the given set of signals and
+   * their respective flags
+   * 
+   * @param initialiser_list Pairs of signals to register and their respective 
+   *                         flags (refer sigaction)
+   * @param throw_sig_error Throws errors (if any) while setting up handler for
+   *                        every signal when true, else skips faulty installs
+   */
+  SignalHandler(
+    std::initializer_list<std::pair<int, int>> initialiser_list,
+    bool throw_sig_error = true
+  );
+};
+
+/// @brief SignalHandler for a set of signals fixed at compile time
+template <int... Sigs>
+class StaticSignalHandler : public SignalHandlerBase
+{
+  static_assert(sizeof...(Sigs) > 0, "At least one signal must be registered");
+  static_assert(((Sigs > 0 && Sigs < NSIG) && ...), "Signal out of range");
+  static_assert(
+    ((Sigs != SIGKILL && Sigs != SIGSTOP) && ...),
+    "SIGKILL and SIGSTOP cannot be handled"
+  );
+
+  // Checks that no signal is listed twice
+  static constexpr bool unique() noexcept
   {
-    /**
-     * Is designed to keep the thread waiting to be interrupted by sigaction
-     * This eliminates the "hijacking" behaviour of sigaction
-     */
+    constexpr int sigs[] = {Sigs...};
+    for (size_t i = 0; i < sizeof...(Sigs); i++)
+    {
+      for (size_t j = i + 1; j < sizeof...(Sigs); j++)
+      {
+        if (sigs[i] == sigs[j])
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+  static_assert(unique(), "Signals must not repeat");
 
-    pthread_sigmask(SIG_UNBLOCK, sigmask_ptr, nullptr);
+  // Bitmask of the registered signals within signal bitmask `flag`
+  static constexpr uint32_t mask_of(SIG_FLAGS_ENM flag) noexcept
+  {
+    return ((flag_index(Sigs) == flag ? signal_bitmask(Sigs) : 0U) | ...);
+  }
 
-    std::unique_lock lock(dispatch_mtx_);
-    cv.wait(lock, [stoken] { return stoken.stop_requested(); });
+public:
+  // Bitmasks of the registered signals
+  static constexpr SignalMask_t MASK = {
+    mask_of(SIG_FLAGS_ENM::OS_sigs),
+    mask_of(SIG_FLAGS_ENM::RT_sigs),
+    mask_of(SIG_FLAGS_ENM::reserved)
   };
 
-  // Restores all old actions of each signal and unblocks the signals
-  void restore_actions() noexcept
+  // Checks whether `sig` is registered
+  static constexpr bool handles(int sig) noexcept
+  {
+    return ((sig == Sigs) || ...);
+  }
+
+  /**
+   * Constructs an instance handling `Sigs`
+   * 
+   * @param flags Flags (refer to sigaction)
+   * @param throw_sig_error Throws errors (if any) while setting up handler for
+   *                        every signal when true, else skips faulty installs
+   */
+  explicit StaticSignalHandler(int flags = 0, bool throw_sig_error = true)
   {
-    for (const auto& it : old_handlers_)
+    (sigaddset(&sigmask_, Sigs), ...);
+    block_signals();
+
+    for (const int signal : {Sigs...})
     {
-      int signum = it.first;
-      const struct sigaction* handler_ptr = &it.second;
-      sigaction(signum, handler_ptr, nullptr);
+      if (!install(signal, flags) && throw_sig_error)
+      {
+        throw std::system_error(errno, std::system_category());
+      }
     }
-    pthread_sigmask(SIG_UNBLOCK, &sigmask_, nullptr);
+
+    subscribe();
   }
 
-  // Enforces singleton behaviour
-  static std::atomic_flag instance_exists_;
+  using SignalHandlerBase::test_signal;
+  using SignalHandlerBase::pop_signal;
 
-  // Array to store the signal state bitmasks
-  static std::atomic<uint32_t> sig_flags_[SIGFLAGN];
+  // Tests whether registered signal `Sig` was raised
+  template <int Sig>
+  bool test_signal() const noexcept
+  {
+    static_assert(handles(Sig), "Signal is not registered");
+    return sig_flags_[flag_index(Sig)].load(std::memory_order::acquire) &
+           signal_bitmask(Sig);
+  }
 
-  // Stores mask of the registered signals
-  sigset_t sigmask_;
-  // Stores the existing handlers
-  std::unordered_map<int, struct sigaction, std::hash<int>> old_handlers_;
-
-  // Dispatch thread
-  std::jthread dispatch_thread_;
-  // Condition variable the dispatch thread waits on
-  std::condition_variable dispatch_cv_;
-  // Mutex for the dispatch thread condition variable
-  std::mutex dispatch_mtx_;
-};
\ No newline at end of file
+  // Tests whether registered signal `Sig` was raised and clears its state
+  template <int Sig>
+  bool pop_signal() noexcept
+  {
+    static_assert(handles(Sig), "Signal is not registered");
+    return sig_flags_[flag_index(Sig)].fetch_and(
+      ~ signal_bitmask(Sig),
+      std::memory_order::release
+    ) & signal_bitmask(Sig);
+  }
+};
@@ -0,0 +1,148 @@
+/**
+ *  ===========================================================================
+ * /                              StackSampler                                /
+ * ===========================================================================
+ *        -- An in-process CPU sampling profiler for managed threads --
+ *
+ * > StackSampler periodically interrupts attached threads through per-thread
+ *   CPU time timers and records their call stacks, for rendering as flame
+ *   graphs where perf is not available
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor ([<interval>][, <signal>])
+ *              - Installs the handler of `signal` (a reserved RT signal,
+ *                SIGRTMIN + DEFAULT_SIGNAL_OFFSET by default). Throws
+ *                std::logic_error if another instance exists
+ *
+ *   (+) bool attach() - Starts sampling the calling thread every `interval`
+ *                       of its CPU time. Returns false if the timer can not
+ *                       be created
+ *   (+) void detach() - Stops sampling the calling thread
+ *   (+) void collect() - Moves the recorded samples of every thread into
+ *                        the aggregated stacks
+ *   (+) void write_folded(std::ostream& out)
+ *              - Collects, then writes the aggregated stacks in the folded
+ *                format ("outer;...;inner <count>" per line) read by
+ *                flamegraph.pl and speedscope
+ *   (+) uint64_t samples() - Returns the number of recorded samples
+ *   (+) uint64_t dropped() - Returns the number of samples lost to full
+ *                            buffers
+ *
+ * > ThreadManager::set_sampler() attaches every thread for the duration of
+ *   the work it is handed; sampling stays off unless one is set. Only
+ *   programs calling set_sampler() need to link src/StackSampler.cpp.
+ * > The signal handler only walks the frame pointer chain, starting from the
+ *   interrupted context, into a single-producer ring owned by the thread; it
+ *   neither locks nor allocates. Symbols are resolved by write_folded().
+ * > Stacks are only complete for code built with frame pointers; configure
+ *   with -DPARALLELLAUNCHER_SAMPLER=ON, which also exports the executable's
+ *   symbols for resolution. Frames without a frame pointer end the walk.
+ * > Attached threads must detach before the instance is destroyed.
+ */
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+
+/// @brief Samples the call stacks of attached threads on CPU time
+class StackSampler
+{
+public:
+  // Magic number: Frames recorded per sample
+  static constexpr size_t MAX_DEPTH = 48UL;
+  // Magic number: Samples buffered per thread between two collect() calls
+  static constexpr size_t RING_SIZE = 256UL;
+  // Magic number: Offset of the default signal from SIGRTMIN
+  static constexpr int DEFAULT_SIGNAL_OFFSET = 3;
+
+  StackSampler(const StackSampler&) = delete;
+  StackSampler& operator= (const StackSampler&) = delete;
+  StackSampler(StackSampler&&) = delete;
+  StackSampler& operator= (StackSampler&&) = delete;
+
+  /**
+   * Installs the sampling handler
+   *
+   * @param interval CPU time of a thread between two of its samples
+   * @param signal Signal delivered by the timers; 0 picks
+   *               SIGRTMIN + DEFAULT_SIGNAL_OFFSET
+   */
+  explicit StackSampler(
+    std::chrono::microseconds interval = std::chrono::milliseconds(10),
+    int signal = 0
+  );
+  // Removes the handler; pending samples are discarded
+  ~StackSampler();
+
+  // Starts sampling the calling thread; false if no timer could be created
+  bool attach() noexcept;
+  // Stops sampling the calling thread
+  void detach() noexcept;
+
+  // Aggregates the samples recorded since the last call
+  void collect();
+  // Writes the aggregated stacks as folded stacks
+  void write_folded(std::ostream& out);
+
+  // Returns the number of samples recorded so far
+  uint64_t samples();
+  // Returns the number of samples dropped because a ring was full
+  uint64_t dropped();
+
+private:
+  struct Sample_t
+  {
+    uint32_t depth;
+    // Innermost frame first
+    uintptr_t pcs[MAX_DEPTH];
+  };
+
+  // Per-thread ring; the signal handler produces, collect() consumes
+  struct ThreadBuffer_t
+  {
+    // Records the stack of the interrupted `context`; async-signal-safe
+    void record(void* context) noexcept;
+
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    // Written by the handler only, hence relaxed
+    std::atomic<uint64_t> dropped{0};
+    // Bounds of the thread's stack, checked by the walk
+    uintptr_t stack_lo = 0;
+    uintptr_t stack_hi = 0;
+    timer_t timer{};
+    // Whether a thread is attached through this buffer
+    bool attached = false;
+    Sample_t ring[RING_SIZE];
+  };
+
+  static void handler_callback(int sig, siginfo_t* info, void* context) noexcept;
+
+  // Buffer of the calling thread while attached
+  static thread_local ThreadBuffer_t* current_;
+  // Whether an instance owns the handler
+  static std::atomic<bool> installed_;
+
+  std::chrono::microseconds interval_;
+  int signal_;
+  struct sigaction old_action_{};
+
+  // Guards everything below
+  std::mutex mtx_;
+  // Buffers are reused by later attach() calls, never freed while in use
+  std::vector<std::unique_ptr<ThreadBuffer_t>> buffers_;
+  std::map<std::vector<uintptr_t>, uint64_t> stacks_;
+};
@@ -0,0 +1,253 @@
+/**
+ *  ===========================================================================
+ * /                              StartBarrier                                /
+ * ===========================================================================
+ *       -- A one-shot futex barrier releasing a gang of workers at once --
+ *
+ * > StartBarrier blocks each of `members` threads or processes until all of
+ *   them arrived, then releases them together and records how far apart
+ *   they actually resumed (refer ThreadManager::spawn_gang)
+ *
+ * > Utilities aside from the class:-
+ *   (+) enum BARRIER_SCOPE_ENM - Whether members are threads of this process,
+ *                                or processes forked after construction
+ *   (+) struct GangSkew_t - Spread of the arrivals and skew of the release
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor (<members>[, <scope>])
+ *
+ *   (+) bool arrive_and_wait() - Blocks until every member arrived. Returns
+ *                                false if the barrier was cancelled instead
+ *   (+) void cancel() - Releases every waiting and future member with false,
+ *                       e.g. once a member fails to launch
+ *   (+) uint32_t members() - Returns the number of members
+ *   (+) bool released() - Checks whether every member resumed
+ *   (+) GangSkew_t report() (throws unless released())
+ *              - Returns the arrival spread, release latency and release
+ *                skew of the gang
+ *
+ * > The barrier is a single futex word: members decrement a counter and
+ *   sleep in the kernel, the last one flips the word and wakes them all with
+ *   one FUTEX_WAKE. Nobody spins, so early members leave their CPUs to the
+ *   ones still starting up.
+ * > With BARRIER_SCOPE_ENM::processes the state lives in a shared anonymous
+ *   mapping and the futex is not process-private, hence children forked
+ *   after construction arrive on the same barrier as the parent.
+ * > Each member stamps its arrival and its release on its own cache line;
+ *   the stamps are taken right around the wait so that report() measures
+ *   the barrier, not the members' work.
+ * > A barrier is used once; arrivals beyond `members` throw.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+/// @brief Who the members of a StartBarrier are
+enum class BARRIER_SCOPE_ENM : uint8_t { threads, processes };
+
+///  @brief Timings of a released gang, in nanoseconds
+struct GangSkew_t
+{
+  // First arrival to last arrival, i.e. how staggered the launch was
+  uint64_t arrival_spread_ns;
+  // Last arrival to last member resuming
+  uint64_t release_latency_ns;
+  // First member resuming to last member resuming
+  uint64_t release_skew_ns;
+};
+
+/// @brief One-shot barrier releasing all members together
+class StartBarrier
+{
+  // Magic number: Assumed size of a cache line
+  static constexpr size_t CACHE_LINE = 64UL;
+
+  // Values of the futex word
+  static constexpr uint32_t WAITING = 0U;
+  static constexpr uint32_t RELEASED = 1U;
+  static constexpr uint32_t CANCELLED = 2U;
+
+  struct alignas(CACHE_LINE) State_t
+  {
+    std::atomic<uint32_t> word{WAITING};
+    std::atomic<uint32_t> arrived{0};
+    std::atomic<uint32_t> resumed{0};
+  };
+
+  // The futex operates on the atomic's storage
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+  static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+  struct alignas(CACHE_LINE) Stamp_t
+  {
+    int64_t arrived;
+    int64_t resumed;
+  };
+
+public:
+  StartBarrier(const StartBarrier&) = delete;
+  StartBarrier& operator= (const StartBarrier&) = delete;
+  StartBarrier(StartBarrier&&) = delete;
+  StartBarrier& operator= (StartBarrier&&) = delete;
+
+  /**
+   * Maps the state of a barrier for `members` members
+   *
+   * @param members Arrivals releasing the barrier (at least one)
+   * @param scope Whether members are threads, or forked processes
+   */
+  explicit StartBarrier(
+    uint32_t members,
+    BARRIER_SCOPE_ENM scope = BARRIER_SCOPE_ENM::threads
+  )
+    : members_(members),
+      futex_op_(scope == BARRIER_SCOPE_ENM::threads ? FUTEX_PRIVATE_FLAG : 0),
+      bytes_(sizeof(State_t) + members * sizeof(Stamp_t))
+  {
+    if (members == 0)
+    {
+      throw std::invalid_argument("StartBarrier needs at least one member");
+    }
+
+    int visibility = scope == BARRIER_SCOPE_ENM::threads ? MAP_PRIVATE : MAP_SHARED;
+    void* region = mmap(
+      nullptr, bytes_, PROT_READ | PROT_WRITE, visibility | MAP_ANONYMOUS, -1, 0
+    );
+    if (region == MAP_FAILED)
+    {
+      throw std::system_error(errno, std::system_category());
+    }
+    state_ = new (region) State_t;
+    stamps_ = new (static_cast<char*>(region) + sizeof(State_t)) Stamp_t[members];
+  }
+
+  ~StartBarrier()
+  {
+    munmap(state_, bytes_);
+  }
+
+  // Blocks until every member arrived; false if cancelled instead
+  bool arrive_and_wait()
+  {
+    int64_t arrival = now();
+    uint32_t rank = state_->arrived.fetch_add(1, std::memory_order::acq_rel);
+    if (rank >= members_)
+    {
+      throw std::length_error("StartBarrier: more arrivals than members");
+    }
+    stamps_[rank].arrived = arrival;
+
+    if (rank + 1 == members_)
+    {
+      release(RELEASED);
+    }
+    else
+    {
+      uint32_t word = state_->word.load(std::memory_order::acquire);
+      while (word == WAITING)
+      {
+        futex(FUTEX_WAIT, WAITING);
+        word = state_->word.load(std::memory_order::acquire);
+      }
+    }
+
+    stamps_[rank].resumed = now();
+    state_->resumed.fetch_add(1, std::memory_order::release);
+    return state_->word.load(std::memory_order::acquire) == RELEASED;
+  }
+
+  // Releases every member with false
+  void cancel() noexcept
+  {
+    release(CANCELLED);
+  }
+
+  uint32_t members() const noexcept
+  {
+    return members_;
+  }
+
+  // Checks whether every member resumed from the barrier
+  bool released() const noexcept
+  {
+    return state_->resumed.load(std::memory_order::acquire) == members_;
+  }
+
+  // Returns the timings of the gang, once every member resumed
+  GangSkew_t report() const
+  {
+    if (!released())
+    {
+      throw std::logic_error("StartBarrier: members still waiting");
+    }
+
+    int64_t first_arrival = INT64_MAX, last_arrival = INT64_MIN;
+    int64_t first_resume = INT64_MAX, last_resume = INT64_MIN;
+    for (uint32_t i = 0; i < members_; i++)
+    {
+      first_arrival = std::min(first_arrival, stamps_[i].arrived);
+      last_arrival = std::max(last_arrival, stamps_[i].arrived);
+      first_resume = std::min(first_resume, stamps_[i].resumed);
+      last_resume = std::max(last_resume, stamps_[i].resumed);
+    }
+
+    GangSkew_t skew{};
+    skew.arrival_spread_ns = static_cast<uint64_t>(last_arrival - first_arrival);
+    skew.release_latency_ns = static_cast<uint64_t>(
+      std::max<int64_t>(last_resume - last_arrival, 0)
+    );
+    skew.release_skew_ns = static_cast<uint64_t>(last_resume - first_resume);
+    return skew;
+  }
+
+private:
+  static int64_t now() noexcept
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+  }
+
+  // Publishes `word` once and wakes every sleeper
+  void release(uint32_t word) noexcept
+  {
+    uint32_t expected = WAITING;
+    if (state_->word.compare_exchange_strong(expected, word, std::memory_order::acq_rel))
+    {
+      futex(FUTEX_WAKE, INT_MAX);
+    }
+  }
+
+  // A spurious return only costs another check of the word
+  long futex(int op, uint32_t value) noexcept
+  {
+    return syscall(
+      SYS_futex, reinterpret_cast<uint32_t*>(&state_->word), op | futex_op_,
+      value, nullptr, nullptr, 0
+    );
+  }
+
+  uint32_t members_;
+  int futex_op_;
+  size_t bytes_;
+  State_t* state_;
+  Stamp_t* stamps_;
+};
@@ -0,0 +1,166 @@
+/**
+ *  ===========================================================================
+ * /                               Supervisor                                 /
+ * ===========================================================================
+ *        -- Restarting workers that throw, within intensity limits --
+ *
+ * > supervise() runs a worker and, whenever it escapes with an exception,
+ *   runs it again on the same thread after a backoff, as long as the restart
+ *   intensity stays within its policy (refer ThreadManager::spawn_supervised)
+ *
+ * > Utilities:-
+ *   (+) struct RestartPolicy_t - Restart intensity, backoff and escalation
+ *   (+) enum ESCALATION_ENM - What happens once the intensity is exceeded:
+ *                             terminate the process (as an unsupervised
+ *                             worker would), give up on the worker, or stop
+ *                             all workers
+ *   (+) std::exception_ptr supervise(<policy>, <local token>, <global token>,
+ *                                    <on restart>, <worker>, <args...>)
+ *              - Returns once the worker returns, or a stop was requested
+ *                while it failed (nullptr), or the policy escalates (the
+ *                last exception)
+ *
+ * > Restarts are one-for-one: only the failed worker runs again, while its
+ *   siblings, and everything the process has warmed up, stay intact.
+ * > Intensity: at most `max_restarts` restarts within any `period`. The
+ *   backoff starts at `initial_backoff`, doubles with every restart up to
+ *   `max_backoff`, and starts over once no restart happened for a `period`.
+ *   Backoffs end early on a stop request, in which case the worker is not
+ *   restarted.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stop_token>
+#include <type_traits>
+#include <vector>
+
+#include <cstdint>
+
+#include <Cancellation.hpp>
+
+
+/// @brief What happens once a worker exceeds its restart intensity
+enum class ESCALATION_ENM : uint8_t { terminate, give_up, stop_all };
+
+/// @brief Restart policy of a supervised worker
+struct RestartPolicy_t
+{
+  // Restarts allowed within any `period`
+  uint32_t max_restarts = 5;
+  std::chrono::milliseconds period = std::chrono::seconds(60);
+  // Wait before the first restart, doubled up to `max_backoff` afterwards
+  std::chrono::milliseconds initial_backoff = std::chrono::milliseconds(10);
+  std::chrono::milliseconds max_backoff = std::chrono::seconds(5);
+  ESCALATION_ENM escalation = ESCALATION_ENM::terminate;
+};
+
+namespace supervisor_detail
+{
+  /**
+   * Sleeps for `duration` unless a stop is requested through either token
+   *
+   * @returns False if a stop was requested
+   */
+  template <typename GlobalToken>
+  bool backoff(
+    std::stop_token local,
+    const GlobalToken& global,
+    std::chrono::milliseconds duration
+  )
+  {
+    std::mutex mtx;
+    std::condition_variable_any cv;
+    auto wake = [&mtx, &cv] () noexcept {
+      std::lock_guard lock(mtx);
+      cv.notify_all();
+    };
+
+    auto wait = [&] {
+      std::unique_lock lock(mtx);
+      cv.wait_for(lock, local, duration, [&global] { return global.stop_requested(); });
+      return !local.stop_requested() && !global.stop_requested();
+    };
+
+    if constexpr (std::is_same_v<GlobalToken, CancellationToken>)
+    {
+      CancellationCallback callback(global, wake);
+      return wait();
+    }
+    else
+    {
+      std::stop_callback callback(global, wake);
+      return wait();
+    }
+  }
+}
+
+/**
+ * Runs `worker(local, global, args...)`, restarting it after exceptions as
+ * `policy` allows
+ *
+ * @param policy Restart intensity, backoff and escalation
+ * @param local Local stop token of the worker
+ * @param global Global token of the worker (std::stop_token or
+ *               CancellationToken)
+ * @param on_restart Called before every restart
+ * @param worker Worker to run
+ * @param args Arguments following the tokens
+ * @returns The exception escalated by the policy, else nullptr
+ */
+template <typename GlobalToken, typename OnRestart, typename Worker, typename... Args>
+std::exception_ptr supervise(
+  const RestartPolicy_t& policy,
+  std::stop_token local,
+  GlobalToken global,
+  OnRestart&& on_restart,
+  Worker& worker,
+  Args&... args
+)
+{
+  std::vector<std::chrono::steady_clock::time_point> restarts;
+  std::chrono::milliseconds backoff = policy.initial_backoff;
+
+  for (;;)
+  {
+    try
+    {
+      worker(local, global, args...);
+      return nullptr;
+    }
+    catch (...)
+    {
+      if (local.stop_requested() || global.stop_requested())
+      {
+        return nullptr;
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      std::erase_if(restarts, [&] (const auto& restart) {
+        return now - restart >= policy.period;
+      });
+      if (restarts.empty())
+      {
+        backoff = policy.initial_backoff;
+      }
+      if (restarts.size() >= policy.max_restarts)
+      {
+        return std::current_exception();
+      }
+      restarts.push_back(now);
+    }
+
+    if (!supervisor_detail::backoff(local, global, backoff))
+    {
+      return nullptr;
+    }
+    backoff = std::min(backoff * 2, policy.max_backoff);
+    on_restart();
+  }
+}
@@ -0,0 +1,603 @@
+/**
+ *  ===========================================================================
+ * /                              ThreadCache                                 /
+ * ===========================================================================
+ *          -- A cache of parked threads to skip thread creation --
+ *
+ * > ThreadCache runs tasks on previously used, parked threads where one is
+ *   available and on a fresh thread otherwise. Once a task returns, its thread
+ *   parks for another task instead of exiting.
+ *
+ * > Utilities aside from the class:-
+ *   (+) class UniqueTask - Move-only, type-erased `void()` callable; callables
+ *                          of up to UniqueTask::INLINE_SIZE bytes are stored
+ *                          inline without allocating
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor ([<max idle>][, <idle timeout>])
+ *
+ *   (+) Worker_t* submit(UniqueTask task[, bool hold])
+ *              - Runs `task` on a parked thread, or on a new one if none is
+ *                parked. With `hold`, the thread takes no other task until
+ *                release() is called for it
+ *   (+) void release(Worker_t* worker) - Lets a held thread take other tasks
+ *                                        once its task returned
+ *   (+) void configure(<max idle>, <idle timeout>) - Changes the idle cap and
+ *                                                    timeout
+ *   (+) void prestart(size_t count) - Starts parked threads until `count` (at
+ *                                     most `max idle`) are parked
+ *   (+) bool enabled() - Checks whether threads are kept at all
+ *   (+) size_t idle_threads() - Returns the number of parked threads
+ *   (+) LockStats_t lock_stats() - Returns the profile of the cache's lock
+ *                                  (all zero unless InternalLock is profiled)
+ *   (+) void shutdown() - Waits for running tasks and stops every thread
+ *
+ * > At most `max idle` threads stay parked; a thread finding the cache full,
+ *   or parked for longer than `idle timeout`, exits. Its bookkeeping is kept
+ *   and recycled by the next thread that has to be created.
+ * > Worker_t objects are never freed before the cache is destroyed, hence
+ *   pointers returned by submit() stay valid, and Worker_t::wait_idle() can
+ *   be used to wait for the submitted task to finish.
+ * > A held thread whose task returned waits outside the idle list until it
+ *   is released, and still exits after `idle timeout`. ThreadManager holds
+ *   every thread until the entry of its work is removed, so a thread id is
+ *   never shared by two entries.
+ * > Parked threads and wait_idle() wait through AdaptiveWaiter, so a task
+ *   handed over right after the previous one returned is picked up by a
+ *   spinning thread within microseconds, while threads parked for long sleep
+ *   on a futex.
+ * > A task escaping with an exception terminates the process, as it would on
+ *   a plain std::thread.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+#include <AdaptiveWait.hpp>
+#include <LockProfiler.hpp>
+
+
+/// @brief Move-only, type-erased `void()` callable
+class UniqueTask
+{
+  struct Base_t
+  {
+    virtual ~Base_t() = default;
+    virtual void run() = 0;
+    // Move constructs this task into `storage`; only called on inline tasks
+    virtual Base_t* move_to(void* storage) noexcept = 0;
+  };
+
+  template <typename Callable>
+  struct Impl_t final : Base_t
+  {
+    explicit Impl_t(Callable&& callable) : callable_(std::move(callable))
+    { }
+    void run() override
+    {
+      callable_();
+    }
+    Base_t* move_to(void* storage) noexcept override
+    {
+      if constexpr (std::is_nothrow_move_constructible_v<Callable>)
+      {
+        return ::new (storage) Impl_t(std::move(callable_));
+      }
+      else
+      {
+        // Such callables are never stored inline
+        std::terminate();
+      }
+    }
+    Callable callable_;
+  };
+
+public:
+  // Magic number: fits the tasks ThreadManager submits, i.e. a worker with a
+  // few captured arguments plus its stop token
+  static constexpr size_t INLINE_SIZE = 128;
+
+  // Checks whether `Callable` is stored without allocating
+  template <typename Callable>
+  static constexpr bool fits_inline =
+    sizeof(Impl_t<Callable>) <= INLINE_SIZE &&
+    alignof(Impl_t<Callable>) <= alignof(std::max_align_t) &&
+    std::is_nothrow_move_constructible_v<Callable>;
+
+  UniqueTask() noexcept = default;
+
+  template <
+    typename Callable,
+    typename = std::enable_if_t<!std::is_same_v<std::decay_t<Callable>, UniqueTask>>
+  >
+  explicit UniqueTask(Callable&& callable)
+  {
+    using Stored = std::decay_t<Callable>;
+    if constexpr (fits_inline<Stored>)
+    {
+      impl_ = ::new (storage_) Impl_t<Stored>(Stored(std::forward<Callable>(callable)));
+      inline_ = true;
+    }
+    else
+    {
+      impl_ = new Impl_t<Stored>(Stored(std::forward<Callable>(callable)));
+    }
+  }
+
+  UniqueTask(UniqueTask&& other) noexcept
+  {
+    take(other);
+  }
+
+  UniqueTask& operator= (UniqueTask&& other) noexcept
+  {
+    if (this != &other)
+    {
+      reset();
+      take(other);
+    }
+    return *this;
+  }
+
+  UniqueTask(const UniqueTask&) = delete;
+  UniqueTask& operator= (const UniqueTask&) = delete;
+
+  ~UniqueTask()
+  {
+    reset();
+  }
+
+  void operator() ()
+  {
+    impl_->run();
+  }
+
+  explicit operator bool() const noexcept
+  {
+    return impl_ != nullptr;
+  }
+
+private:
+  void reset() noexcept
+  {
+    if (inline_)
+    {
+      impl_->~Base_t();
+    }
+    else
+    {
+      delete impl_;
+    }
+    impl_ = nullptr;
+    inline_ = false;
+  }
+
+  // Moves the task out of `other`, leaving it empty; this must be empty
+  void take(UniqueTask& other) noexcept
+  {
+    if (other.inline_)
+    {
+      impl_ = other.impl_->move_to(storage_);
+      inline_ = true;
+      other.reset();
+    }
+    else
+    {
+      impl_ = std::exchange(other.impl_, nullptr);
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[INLINE_SIZE];
+  Base_t* impl_ = nullptr;
+  // Whether impl_ lives in storage_
+  bool inline_ = false;
+};
+
+/// @brief Runs tasks on parked threads, creating threads only when needed
+class ThreadCache
+{
+public:
+  /// @brief A thread owned by the cache
+  struct Worker_t
+  {
+    // Blocks until the last submitted task has returned
+    void wait_idle() const noexcept
+    {
+      idle.wait([this] { return !busy.load(std::memory_order::acquire); });
+    }
+
+    std::jthread thread;
+    std::thread::id id;
+    std::atomic<bool> busy{false};
+    mutable AdaptiveWaiter idle;
+
+    // Set once a task, or the request to exit (no task), is handed over,
+    // so the parked thread can poll without taking mtx
+    std::atomic<bool> pending{false};
+    AdaptiveWaiter parking;
+
+    // Guards task
+    std::mutex mtx;
+    UniqueTask task;
+
+    // Guarded by the cache's lock: whether the submitter still holds the
+    // thread, and whether its thread exited while held
+    bool held = false;
+    bool exited = false;
+  };
+
+  ThreadCache(const ThreadCache&) = delete;
+  ThreadCache& operator= (const ThreadCache&) = delete;
+  ThreadCache(ThreadCache&&) = delete;
+  ThreadCache& operator= (ThreadCache&&) = delete;
+
+  /**
+   * Constructs a cache
+   *
+   * @param max_idle Maximum number of parked threads; 0 disables caching
+   * @param idle_timeout Time a thread stays parked before exiting
+   */
+  explicit ThreadCache(
+    size_t max_idle = 0,
+    std::chrono::milliseconds idle_timeout = std::chrono::seconds(10)
+  ) : max_idle_(max_idle), idle_timeout_ms_(idle_timeout.count())
+  { }
+
+  ~ThreadCache()
+  {
+    shutdown();
+  }
+
+  /**
+   * Runs `task` on a parked thread, or on a new thread if none is parked
+   *
+   * @param task Task to run
+   * @param hold Keeps the thread from taking other tasks until release()
+   * @returns The worker running the task
+   */
+  Worker_t* submit(UniqueTask task, bool hold = false)
+  {
+    std::unique_lock lock(mtx_);
+
+    if (!idle_.empty())
+    {
+      Worker_t* worker = idle_.back();
+      idle_.pop_back();
+      worker->held = hold;
+      lock.unlock();
+
+      {
+        std::lock_guard worker_lock(worker->mtx);
+        worker->busy.store(true, std::memory_order::relaxed);
+        worker->task = std::move(task);
+        worker->pending.store(true, std::memory_order::release);
+      }
+      worker->parking.notify_one();
+      return worker;
+    }
+
+    Worker_t* worker = take_unused();
+    worker->held = hold;
+    worker->exited = false;
+    // A retired thread may still need mtx_ on its way out
+    lock.unlock();
+
+    if (worker->thread.joinable())
+    {
+      worker->thread.join();
+    }
+    worker->busy.store(true, std::memory_order::relaxed);
+    worker->task = std::move(task);
+    worker->pending.store(true, std::memory_order::relaxed);
+    try
+    {
+      worker->thread = std::jthread(&ThreadCache::run, this, worker);
+    }
+    catch (...)
+    {
+      worker->task = UniqueTask();
+      worker->busy.store(false, std::memory_order::relaxed);
+      worker->pending.store(false, std::memory_order::relaxed);
+      lock.lock();
+      worker->held = false;
+      retired_.push_back(worker);
+      throw;
+    }
+    worker->id = worker->thread.get_id();
+
+    return worker;
+  }
+
+  /**
+   * Lets a thread submitted with `hold` take other tasks once its task
+   * returned; parks it, or lets it exit if the cache is full
+   *
+   * @param worker Worker returned by submit()
+   */
+  void release(Worker_t* worker)
+  {
+    std::lock_guard lock(mtx_);
+    worker->held = false;
+    if (worker->busy.load(std::memory_order::relaxed))
+    {
+      // Parks (or exits) by itself once the task returns
+      return;
+    }
+    if (worker->exited)
+    {
+      retired_.push_back(worker);
+    }
+    else if (!shutdown_ && idle_.size() < max_idle_.load(std::memory_order::relaxed))
+    {
+      idle_.push_back(worker);
+    }
+    else
+    {
+      retire_parked(worker);
+    }
+  }
+
+  /**
+   * Changes the idle cap and timeout; parked threads beyond the new cap exit
+   *
+   * @param max_idle Maximum number of parked threads; 0 disables caching
+   * @param idle_timeout Time a thread stays parked before exiting
+   */
+  void configure(size_t max_idle, std::chrono::milliseconds idle_timeout)
+  {
+    std::lock_guard lock(mtx_);
+    max_idle_.store(max_idle, std::memory_order::relaxed);
+    idle_timeout_ms_.store(idle_timeout.count(), std::memory_order::relaxed);
+
+    while (idle_.size() > max_idle)
+    {
+      retire_parked(idle_.front());
+      idle_.erase(idle_.begin());
+    }
+  }
+
+  /**
+   * Starts threads that park right away until `count` threads are parked (at
+   * most `max idle`), so later submits do not create threads
+   *
+   * @param count Number of parked threads wanted
+   */
+  void prestart(size_t count)
+  {
+    std::unique_lock lock(mtx_);
+    while (!shutdown_ &&
+           idle_.size() < std::min(count, max_idle_.load(std::memory_order::relaxed)))
+    {
+      Worker_t* worker = take_unused();
+      lock.unlock();
+
+      if (worker->thread.joinable())
+      {
+        worker->thread.join();
+      }
+      worker->held = false;
+      worker->exited = false;
+      worker->busy.store(false, std::memory_order::relaxed);
+      worker->pending.store(false, std::memory_order::relaxed);
+      try
+      {
+        worker->thread = std::jthread(&ThreadCache::run, this, worker);
+      }
+      catch (...)
+      {
+        lock.lock();
+        retired_.push_back(worker);
+        throw;
+      }
+      worker->id = worker->thread.get_id();
+
+      lock.lock();
+      idle_.push_back(worker);
+    }
+  }
+
+  // Checks whether finished threads are kept at all
+  bool enabled() const noexcept
+  {
+    return max_idle_.load(std::memory_order::relaxed) != 0;
+  }
+
+  // Returns the number of parked threads
+  size_t idle_threads()
+  {
+    std::lock_guard lock(mtx_);
+    return idle_.size();
+  }
+
+  // Returns the profile of mtx_; all zero unless InternalLock is profiled
+  LockStats_t lock_stats() const noexcept
+  {
+#ifdef PARALLELLAUNCHER_LOCK_PROFILING
+    return mtx_.stats();
+#else
+    return {};
+#endif
+  }
+
+  // Waits for running tasks to return and stops every thread
+  void shutdown() noexcept
+  {
+    {
+      std::lock_guard lock(mtx_);
+      shutdown_ = true;
+      for (Worker_t* worker : idle_)
+      {
+        retire_parked(worker);
+      }
+      idle_.clear();
+
+      // Held threads whose task returned wait outside the idle list
+      for (Worker_t& worker : workers_)
+      {
+        if (worker.held && !worker.exited && !worker.busy.load(std::memory_order::relaxed))
+        {
+          worker.exited = true;
+          signal_exit(&worker);
+        }
+      }
+    }
+
+    for (auto& worker : workers_)
+    {
+      if (worker.thread.joinable())
+      {
+        worker.thread.join();
+      }
+    }
+  }
+
+private:
+  // Thread body: runs the handed task, then parks for the next one
+  void run(Worker_t* worker) noexcept
+  {
+    for (;;)
+    {
+      UniqueTask task;
+      {
+        auto has_work = [worker] {
+          return worker->pending.load(std::memory_order::acquire);
+        };
+
+        auto timeout = std::chrono::milliseconds(
+          idle_timeout_ms_.load(std::memory_order::relaxed)
+        );
+        if (!worker->parking.wait_until(has_work, std::chrono::steady_clock::now() + timeout))
+        {
+          if (unpark(worker))
+          {
+            return;
+          }
+          // A task is being handed over concurrently
+          worker->parking.wait(has_work);
+        }
+
+        std::lock_guard lock(worker->mtx);
+        worker->pending.store(false, std::memory_order::relaxed);
+        if (!worker->task)
+        {
+          return;
+        }
+        task = std::move(worker->task);
+      }
+
+      task();
+      // Captured state is released before the task is reported done
+      task = UniqueTask();
+      bool parked = park(worker);
+      worker->idle.notify_all();
+
+      if (!parked)
+      {
+        return;
+      }
+    }
+  }
+
+  // Recycles the bookkeeping of a thread that exited, else makes a new one;
+  // caller holds mtx_
+  Worker_t* take_unused()
+  {
+    if (!retired_.empty())
+    {
+      Worker_t* worker = retired_.back();
+      retired_.pop_back();
+      return worker;
+    }
+    Worker_t* worker = &workers_.emplace_back();
+    retired_.reserve(workers_.size());
+    idle_.reserve(workers_.size());
+    return worker;
+  }
+
+  // Parks `worker` and reports its task done; returns false if it should exit
+  // instead. Reporting under mtx_ means a thread woken by wait_idle() finds
+  // the worker parked already, and no submit can race with the report
+  bool park(Worker_t* worker)
+  {
+    std::lock_guard lock(mtx_);
+    worker->busy.store(false, std::memory_order::release);
+    if (worker->held)
+    {
+      // Waits for release() outside the idle list, unless shutting down;
+      // release() then recycles it
+      worker->exited = shutdown_;
+      return !shutdown_;
+    }
+
+    bool keep = !shutdown_ && idle_.size() < max_idle_.load(std::memory_order::relaxed);
+    (keep ? idle_ : retired_).push_back(worker);
+    return keep;
+  }
+
+  // Removes a timed out `worker` from the idle list; false if it was taken
+  // or told to exit meanwhile
+  bool unpark(Worker_t* worker)
+  {
+    std::lock_guard lock(mtx_);
+    auto it = std::find(idle_.begin(), idle_.end(), worker);
+    if (it != idle_.end())
+    {
+      idle_.erase(it);
+      retired_.push_back(worker);
+      return true;
+    }
+    if (worker->held && !worker->exited)
+    {
+      // Recycled by release()
+      worker->exited = true;
+      return true;
+    }
+    return false;
+  }
+
+  // Tells a parked worker to exit; caller holds mtx_
+  void retire_parked(Worker_t* worker)
+  {
+    signal_exit(worker);
+    retired_.push_back(worker);
+  }
+
+  // Hands a parked worker the request to exit
+  static void signal_exit(Worker_t* worker)
+  {
+    {
+      std::lock_guard worker_lock(worker->mtx);
+      worker->pending.store(true, std::memory_order::release);
+    }
+    worker->parking.notify_one();
+  }
+
+  // Written under mtx_, read without it by enabled() and parked threads
+  std::atomic<size_t> max_idle_;
+  std::atomic<std::chrono::milliseconds::rep> idle_timeout_ms_;
+
+  // Guards everything below
+  InternalLock mtx_;
+  bool shutdown_ = false;
+
+  // Owns every worker; std::list keeps their addresses stable
+  std::list<Worker_t> workers_;
+  // Parked workers, most recently parked last
+  std::vector<Worker_t*> idle_;
+  // Workers whose thread exited (or is exiting) and may be recycled
+  std::vector<Worker_t*> retired_;
+};
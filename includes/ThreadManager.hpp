@@ -13,14 +13,64 @@
  *                function and its arguments. The function must however have
  *                two std::stop_token arguments as its first and second
  *                parameters, one for a local stop token, one for a global
- *                token.
+ *                token. The global token may instead be taken as a
+ *                CancellationToken, which is cheaper to hand out; so may the
+ *                local one, when the global one is a CancellationToken too.
+ *   (+) std::thread::id spawn_supervised(<policy>, <function>[, <args...>])
+ *              - Same as above, but an exception escaping the function
+ *                restarts it on the same thread as RestartPolicy_t allows,
+ *                instead of terminating the process (refer Supervisor.hpp)
+ *   (+) void spawn_many(<ids>, <function>[, <args generator>])
+ *              - Spawns one copy of the function per element of `ids` (a
+ *                std::span) under a single registry lock hold and counter
+ *                update, writing the thread ids into it. The i-th thread
+ *                gets the elements of the tuple `generator(i)` as its
+ *                further arguments
+ *   (+) std::vector<std::thread::id> spawn_gang(<barrier>, <function>[, <args...>])
+ *              - Spawns one copy of the function per member of `barrier`
+ *                (a StartBarrier) and releases them together once all are
+ *                running; barrier.report() tells the release skew
  *   (+) void reserve(uint32_t limit) - Reserve space for at least `limit` 
- *                                      number of threads
- *   (+) size_t capacity() - Returns the limit (if set, else undefined)
+ *                                      number of threads. With the thread
+ *                                      cache enabled, also prestarts up to
+ *                                      `limit` parked threads and keeps
+ *                                      `limit` stop states for reuse
+ *   (+) size_t capacity() - Returns the limit (if set, else undefined).
+ *                           Takes the registry lock
+ *   (+) void set_thread_cache(<max idle>[, <idle timeout>])
+ *              - Lets spawn_thread() hand work to up to `max idle` parked
+ *                threads whose previous work returned, instead of creating a
+ *                new thread each time. 0 (default) disables the cache
+ *   (+) size_t cached_threads() - Returns the number of parked threads
+ *   (+) void set_watchdog(<deadline>[, <action>][, <slots>])
+ *              - Starts a monitor thread flagging work spawned from now on
+ *                that goes `deadline` without calling heartbeat(), and with
+ *                WATCHDOG_ACTION_ENM::stop also requesting it to stop. Up to
+ *                `slots` works are monitored at once. May be set once
+ *   (+) size_t stalled_threads() - Returns the number of work found stalled
+ *                                  by the last scan of the watchdog
+ *   (+) void enable_reaper() - Starts a background thread that joins and
+ *                              removes finished threads as they finish, so
+ *                              the registry does not grow between join()
+ *                              calls. May be enabled once, and not with
+ *                              NullLock
+ *   (+) bool reaper_enabled() - Checks whether the reaper was enabled
+ *   (+) int completion_fd() - Returns an eventfd (created on first call) that
+ *                             is readable while finished work is pending
+ *                             for drain_completions(), for epoll loops
+ *   (+) size_t drain_completions(std::vector<std::thread::id>& out[, <max>])
+ *              - Moves up to `max` ids of work finished since
+ *                completion_fd() was first called into `out`, oldest
+ *                first, without blocking; returns the number moved
+ *   (+) void set_sampler(StackSampler* sampler)
+ *              - Attaches `sampler` to every thread while it runs work
+ *                spawned from now on; nullptr (default) disables sampling
  * 
- *   (+) bool request_stop_all() - Sends a stop request via the global stop
- *                                 token
+ *   (+) bool request_stop_all([<dispatch threads>]) 
+ *              - Sends a stop request via the global stop token, running the
+ *                registered callbacks on up to `dispatch threads` threads
  *   (+) bool stop_requested_all() - Checks if a global stop was requested
+ *   (+) CancellationToken global_token() - Returns a borrowed global token
  * 
  *   (+) bool request_stop(const std::threads::id& tid) (throws for tid out of 
  *                                                       bounds)
@@ -36,166 +86,1116 @@
  *                     concurrent call to spawn_thread() might cause a livelock.
  *                     Clears all dead threads from the manager
  *   (+) bool all_running() - Checks whether all created threads are running.
- *                            Guarantees wait-free response
+ *                            Takes the registry lock
  *   (+) bool any_running() - Checks whether any created threads are running.
- *                            Guarantees wait-free response
+ *                            Lock-free, never blocks on the registry
  *   (+) size_t total_threads() - Returns the total number of threads in the
- *                                manager
+ *                                manager. Takes the registry lock
  *   (+) size_t alive_threads() - Returns the count of threads still running (
  *                                or in the process of shutting down)
+ *   (+) ThreadManagerStats_t stats() - Returns the statistics gathered by the
+ *                                      stats policy (all zero for NoStats),
+ *                                      and the profiles of profiled locks
+ * 
+ * > ThreadManager is an alias of BasicThreadManager with its default policies:
+ *   hash map registry, InternalLock, per-CPU counter and no statistics. Other
+ *   combinations are picked at compile time, e.g.
+ *   BasicThreadManager<FixedRegistry<64>, SpinLock, AtomicCounter,
+ *   CountingStats>; refer ThreadManagerPolicies.hpp for the options.
+ * 
+ * > Steady state without allocations: enable the thread cache, then call
+ *   reserve(). While at most `limit` threads are managed and workers fit
+ *   UniqueTask::INLINE_SIZE, spawn_thread(), request_stop() and join() do not
+ *   touch the heap. Local stops of workers taking two CancellationTokens come
+ *   from a pool of CancellationSources, re-armed by join() or the reaper once
+ *   their work returned. A std::stop_token's stop state cannot be re-armed:
+ *   it is only reused if no stop was requested through it, hence
+ *   request_stop() on such work costs one allocation at its next spawn.
+ *   Either way, local tokens must not outlive their work.
+ * > With the thread cache enabled, a parked thread only takes new work once
+ *   the entry of its previous work was removed by join() or the reaper.
+ *   Hence every spawn keeps an entry and an id of its own until joined, as
+ *   without the cache, and the cache saves thread creation for spawns that
+ *   follow a join() or the reaper. join() waits for the work to return
+ *   rather than for the parked thread to exit.
+ * > With the reaper enabled, the entry of a thread disappears shortly after
+ *   its work returns, hence total_threads() counts unfinished work only and
+ *   request_stop() may throw for work that just returned. Each entry is
+ *   removed under its own short hold of the registry lock, and threads are
+ *   joined outside of it, so spawns are never blocked for a whole cleanup.
+ * > Completions are queued by the finishing threads, and the eventfd is only
+ *   written when the queue turns non-empty and only read once it is drained,
+ *   hence a burst of completions costs one wake-up of the event loop. Ids of
+ *   cached threads may appear once per work they ran. The queue grows until
+ *   drained.
+ * > spawn_thread(), the start and exit of work, request_stop(),
+ *   request_stop_all() and join() carry USDT probes (refer Probes.hpp).
  */
 
 #pragma once
 
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <sstream>
+#include <stdexcept>
 #include <stop_token>
+#include <system_error>
 #include <thread>
-#include <unordered_map>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
+#include <cerrno>
+#include <cstddef>
 #include <cstdint>
 
+#include <Cancellation.hpp>
+#include <Heartbeat.hpp>
+#include <PerCpuCounter.hpp>
+#include <Probes.hpp>
+#include <StackSampler.hpp>
+#include <StartBarrier.hpp>
+#include <Supervisor.hpp>
+#include <ThreadCache.hpp>
+#include <ThreadManagerPolicies.hpp>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 /// @brief Allows creation and management of threads
-class ThreadManager
+template <
+  typename RegistryPolicy = HashRegistry,
+  typename LockPolicy = InternalLock,
+  typename CounterPolicy = PerCpuCounter,
+  typename StatsPolicy = NoStats
+>
+class BasicThreadManager
 {
 public:
-  ThreadManager(const ThreadManager&) = delete;
-  ThreadManager& operator= (const ThreadManager&) = delete;
-  ThreadManager(ThreadManager&&) = delete;
-  ThreadManager& operator= (ThreadManager&&) = delete;
+  BasicThreadManager(const BasicThreadManager&) = delete;
+  BasicThreadManager& operator= (const BasicThreadManager&) = delete;
+  BasicThreadManager(BasicThreadManager&&) = delete;
+  BasicThreadManager& operator= (BasicThreadManager&&) = delete;
 
-  ThreadManager() = default;
+  BasicThreadManager() = default;
+
+  ~BasicThreadManager()
+  {
+    {
+      // Cached threads and pooled local sources do not stop with their
+      // entry, unlike std::jthread
+      std::lock_guard lock(threads_mtx_);
+      threads_.for_each([] (ManagedThread_t& managed) {
+        if (managed.cached || managed.local_source)
+        {
+          managed.request_stop();
+        }
+      });
+    }
+    thread_cache_.shutdown();
+  }
 
   // Immediately creates a new thread with the given function and arguments
   template <typename Callable, typename... Args>
   std::thread::id spawn_thread(Callable&& worker, Args&&... args)
   {
-    thread_counter_.fetch_add(1, std::memory_order::seq_cst);
+    PARALLELLAUNCHER_PROBE(spawn__start, this);
+    thread_counter_.add(1);
     std::lock_guard lock(threads_mtx_);
+    // Once launched, the work itself decrements the counter on return
+    bool launched = false;
     std::thread::id tid;
 
     try
     {
-      std::jthread thread(
-        [
-          this, 
-          worker = std::forward<Callable>(worker), 
-          ... args = std::forward<Args>(args)
-        ]
-        (std::stop_token local_stoken) mutable {
-          worker(
-            local_stoken, 
-            global_stop_source_.get_token(), 
-            args...
-          );
-          thread_counter_.fetch_sub(1, std::memory_order::seq_cst);
-      });
-      tid = thread.get_id();
-      threads_[tid] = std::move(thread);
+      tid = launch(launched, std::forward<Callable>(worker), std::forward<Args>(args)...);
     }
     catch (...)
     {
-      thread_counter_.fetch_sub(1, std::memory_order::seq_cst);
+      if (!launched)
+      {
+        thread_counter_.sub(1);
+      }
       throw;
     }
 
+    stats_.on_spawn();
+    PARALLELLAUNCHER_PROBE(spawn__done, this, probe_key(tid));
     return tid;
   }
 
+  /**
+   * Spawns one copy of `worker` per element of `out` under a single hold of
+   * the registry lock, writing the thread ids into `out`
+   *
+   * @param out Receives the ids in spawn order; its size is the number of
+   *            threads. Should a spawn throw, the ids of the threads already
+   *            running are kept and the rest are reset to std::thread::id()
+   * @param worker Worker taking the local and global tokens first, copied
+   *               for every thread
+   * @param make_args Called as `make_args(i)` for the i-th thread; returns a
+   *                  std::tuple of the further arguments of its worker
+   */
+  template <typename Callable, typename ArgsGenerator>
+  void spawn_many(
+    std::span<std::thread::id> out,
+    const Callable& worker,
+    ArgsGenerator&& make_args
+  )
+  {
+    thread_counter_.add(static_cast<int64_t>(out.size()));
+    std::lock_guard lock(threads_mtx_);
+    size_t spawned = 0;
+    bool launched = false;
+
+    try
+    {
+      threads_.reserve(threads_.size() + out.size());
+      for (; spawned < out.size(); spawned++)
+      {
+        PARALLELLAUNCHER_PROBE(spawn__start, this);
+        launched = false;
+        out[spawned] = std::apply(
+          [&] (auto&&... args) {
+            return launch(launched, worker, std::forward<decltype(args)>(args)...);
+          },
+          make_args(spawned)
+        );
+        PARALLELLAUNCHER_PROBE(spawn__done, this, probe_key(out[spawned]));
+      }
+    }
+    catch (...)
+    {
+      size_t running = spawned + (launched ? 1 : 0);
+      thread_counter_.sub(static_cast<int64_t>(out.size() - running));
+      std::fill(out.begin() + static_cast<std::ptrdiff_t>(spawned), out.end(), std::thread::id());
+      stats_.on_spawn(running);
+      throw;
+    }
+
+    stats_.on_spawn(out.size());
+  }
+
+  // Same as above, for workers without further arguments
+  template <typename Callable>
+  void spawn_many(std::span<std::thread::id> out, const Callable& worker)
+  {
+    spawn_many(out, worker, [] (size_t) { return std::tuple<>(); });
+  }
+
+  /**
+   * Spawns `worker` like spawn_thread(), restarting it after exceptions
+   *
+   * @param policy Restart intensity, backoff and escalation
+   * @param worker Worker taking the local and global tokens first
+   * @param args Further arguments of the worker
+   * @returns The id of the thread running the worker
+   */
+  template <typename Callable, typename... Args>
+  std::thread::id spawn_supervised(
+    RestartPolicy_t policy,
+    Callable&& worker,
+    Args&&... args
+  )
+  {
+    auto run = [this, policy] (
+      std::stop_token local_stoken,
+      auto global_token,
+      auto& supervised,
+      auto&... supervised_args
+    ) {
+      std::exception_ptr failure = supervise(
+        policy, local_stoken, global_token,
+        [this] {
+          stats_.on_restart();
+          PARALLELLAUNCHER_PROBE(
+            worker__restart, this, probe_key(std::this_thread::get_id())
+          );
+        },
+        supervised, supervised_args...
+      );
+      if (!failure)
+      {
+        return;
+      }
+
+      stats_.on_escalation();
+      switch (policy.escalation)
+      {
+        case ESCALATION_ENM::terminate:
+          // Escaping the thread terminates, as without supervision
+          std::rethrow_exception(failure);
+        case ESCALATION_ENM::stop_all:
+          request_stop_all();
+          break;
+        case ESCALATION_ENM::give_up:
+          break;
+      }
+    };
+
+    // Hands the worker the same kind of global token spawn_thread() would
+    if constexpr (std::is_invocable_v<
+      std::decay_t<Callable>&,
+      std::stop_token,
+      CancellationToken,
+      std::decay_t<Args>&...
+    >)
+    {
+      return spawn_thread(
+        [run] (
+          std::stop_token local_stoken,
+          CancellationToken global_token,
+          std::decay_t<Callable>& supervised,
+          std::decay_t<Args>&... supervised_args
+        ) mutable {
+          run(local_stoken, global_token, supervised, supervised_args...);
+        },
+        std::forward<Callable>(worker),
+        std::forward<Args>(args)...
+      );
+    }
+    else
+    {
+      return spawn_thread(
+        [run] (
+          std::stop_token local_stoken,
+          std::stop_token global_stoken,
+          std::decay_t<Callable>& supervised,
+          std::decay_t<Args>&... supervised_args
+        ) mutable {
+          run(local_stoken, global_stoken, supervised, supervised_args...);
+        },
+        std::forward<Callable>(worker),
+        std::forward<Args>(args)...
+      );
+    }
+  }
+
+  /**
+   * Spawns one copy of `worker` per member of `barrier`, all starting
+   * together once every member is running
+   *
+   * @param barrier Unused barrier, outliving the release of its members
+   * @param worker Worker taking the local and global tokens first, copied
+   *               for every member
+   * @param args Further arguments of the worker, copied for every member
+   * @returns The ids of the threads, in spawn order
+   */
+  template <typename Callable, typename... Args>
+  std::vector<std::thread::id> spawn_gang(
+    StartBarrier& barrier,
+    const Callable& worker,
+    const Args&... args
+  )
+  {
+    std::vector<std::thread::id> tids;
+    tids.reserve(barrier.members());
+
+    auto member = [&barrier] (
+      std::stop_token local_stoken,
+      auto global_token,
+      Callable& gang_worker,
+      Args&... gang_args
+    ) {
+      // Members spawned before a failed launch must not wait forever
+      if (barrier.arrive_and_wait())
+      {
+        gang_worker(local_stoken, global_token, gang_args...);
+      }
+    };
+
+    try
+    {
+      for (uint32_t i = 0; i < barrier.members(); i++)
+      {
+        // Hands the worker the same kind of global token spawn_thread() would
+        if constexpr (std::is_invocable_v<
+          Callable&,
+          std::stop_token,
+          CancellationToken,
+          Args&...
+        >)
+        {
+          tids.push_back(spawn_thread(
+            [member] (
+              std::stop_token local_stoken,
+              CancellationToken global_token,
+              Callable& gang_worker,
+              Args&... gang_args
+            ) {
+              member(local_stoken, global_token, gang_worker, gang_args...);
+            },
+            worker, args...
+          ));
+        }
+        else
+        {
+          tids.push_back(spawn_thread(
+            [member] (
+              std::stop_token local_stoken,
+              std::stop_token global_stoken,
+              Callable& gang_worker,
+              Args&... gang_args
+            ) {
+              member(local_stoken, global_stoken, gang_worker, gang_args...);
+            },
+            worker, args...
+          ));
+        }
+      }
+    }
+    catch (...)
+    {
+      barrier.cancel();
+      throw;
+    }
+    return tids;
+  }
+
   // Reserves space for at least `limit` threads
   void reserve(uint32_t limit)
   {
-    threads_.max_load_factor(1.0F);
-    threads_.rehash(limit);
+    std::lock_guard lock(threads_mtx_);
+    threads_.reserve(limit);
+    {
+      std::lock_guard completions_lock(completions_mtx_);
+      completions_.reserve(limit);
+    }
+    {
+      std::lock_guard finished_lock(finished_mtx_);
+      finished_.reserve(limit);
+    }
+
+    if (thread_cache_.enabled())
+    {
+      spare_stop_sources_.reserve(limit);
+      while (spare_stop_sources_.size() < limit)
+      {
+        spare_stop_sources_.emplace_back();
+      }
+      spare_local_sources_.reserve(limit);
+      while (spare_local_sources_.size() < limit)
+      {
+        spare_local_sources_.push_back(std::make_unique<CancellationSource>());
+      }
+      thread_cache_.prestart(limit);
+    }
   }
 
   // Returns capacity after reserving space
-  size_t capacity()
+  size_t capacity() const noexcept
+  {
+    // The reaper may be removing entries concurrently
+    std::lock_guard lock(threads_mtx_);
+    return threads_.capacity();
+  }
+
+  // Keeps up to `max_idle` threads parked for reuse by spawn_thread()
+  void set_thread_cache(
+    size_t max_idle,
+    std::chrono::milliseconds idle_timeout = std::chrono::seconds(10)
+  )
+  {
+    thread_cache_.configure(max_idle, idle_timeout);
+  }
+
+  // Returns the number of parked threads
+  size_t cached_threads()
+  {
+    return thread_cache_.idle_threads();
+  }
+
+  /**
+   * Starts a monitor thread watching the heartbeats of work spawned from now
+   * on; work must call heartbeat() at least every `deadline`
+   *
+   * @param deadline Longest allowed time between two heartbeats
+   * @param action Whether stalled work is only flagged or also stopped
+   * @param slots Number of works monitored at once; later ones go unwatched
+   */
+  void set_watchdog(
+    std::chrono::milliseconds deadline,
+    WATCHDOG_ACTION_ENM action = WATCHDOG_ACTION_ENM::flag,
+    size_t slots = 256
+  )
+  {
+    if (deadline.count() <= 0 || slots == 0)
+    {
+      throw std::invalid_argument("The watchdog needs a deadline and slots");
+    }
+
+    std::lock_guard lock(threads_mtx_);
+    if (heartbeats_)
+    {
+      throw std::logic_error("The watchdog is already set");
+    }
+    heartbeats_ = std::make_unique<HeartbeatTable>(slots);
+    watchdog_deadline_ = deadline;
+    watchdog_action_ = action;
+    watchdog_ = std::jthread([this] (std::stop_token stoken) {
+      watch(stoken);
+    });
+  }
+
+  // Starts the background thread removing finished threads
+  void enable_reaper()
+  {
+    static_assert(!std::is_same_v<LockPolicy, NullLock>,
+                  "The reaper thread accesses the registry concurrently");
+    std::lock_guard lock(threads_mtx_);
+    if (reaper_.joinable())
+    {
+      throw std::logic_error("The reaper is already enabled");
+    }
+    reaper_ = std::jthread([this] (std::stop_token stoken) {
+      reap(stoken);
+    });
+    reaping_.store(true, std::memory_order::release);
+  }
+
+  // Checks whether the reaper was enabled
+  bool reaper_enabled() const noexcept
+  {
+    return reaping_.load(std::memory_order::acquire);
+  }
+
+  // Returns the number of work stalled at the last scan of the watchdog
+  size_t stalled_threads() const noexcept
   {
-    return threads_.bucket_count();
+    return stalled_now_.load(std::memory_order::relaxed);
+  }
+
+  /**
+   * Returns an eventfd that is readable while completions are pending,
+   * creating it on the first call; work finishing from then on is queued
+   * for drain_completions(). The descriptor is owned by the manager
+   *
+   * @returns The non-blocking eventfd
+   */
+  int completion_fd()
+  {
+    std::lock_guard lock(completions_mtx_);
+    int fd = completion_fd_.fd.load(std::memory_order::relaxed);
+    if (fd == -1)
+    {
+      fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if (fd == -1)
+      {
+        throw std::system_error(errno, std::system_category());
+      }
+      completion_fd_.fd.store(fd, std::memory_order::release);
+    }
+    return fd;
+  }
+
+  /**
+   * Moves the ids of finished work into `out` without blocking, and resets
+   * completion_fd() once none are left
+   *
+   * @param out Receives the ids, oldest first; appended to
+   * @param max Most ids to move in this batch
+   * @returns The number of ids moved
+   */
+  size_t drain_completions(
+    std::vector<std::thread::id>& out,
+    size_t max = SIZE_MAX
+  )
+  {
+    std::lock_guard lock(completions_mtx_);
+    size_t count = std::min(max, completions_.size());
+    auto batch_end = completions_.begin() + static_cast<std::ptrdiff_t>(count);
+    out.insert(out.end(), completions_.begin(), batch_end);
+    completions_.erase(completions_.begin(), batch_end);
+
+    if (completions_.empty() && count != 0)
+    {
+      // Completions are only queued under the lock, so nothing is lost
+      uint64_t pending = 0;
+      [[maybe_unused]] ssize_t drained = read(
+        completion_fd_.fd.load(std::memory_order::relaxed), &pending, sizeof(pending)
+      );
+    }
+    return count;
+  }
+
+  // Samples the stacks of work spawned from now on; nullptr stops sampling
+  void set_sampler(StackSampler* sampler) noexcept
+  {
+    // Bound here rather than by the workers, so that only programs calling
+    // set_sampler() need StackSampler's definitions
+    sampler_attach_.store(
+      [] (StackSampler* attached) noexcept { return attached->attach(); },
+      std::memory_order::relaxed
+    );
+    sampler_detach_.store(
+      [] (StackSampler* attached) noexcept { attached->detach(); },
+      std::memory_order::relaxed
+    );
+    sampler_.store(sampler, std::memory_order::release);
   }
   
-  // Sends global stop request
-  bool request_stop_all() noexcept
+  // Sends global stop request, running its callbacks on up to
+  // `dispatch_threads` threads
+  bool request_stop_all(unsigned dispatch_threads = 1) noexcept
   {
-    return global_stop_source_.request_stop();
+    PARALLELLAUNCHER_PROBE(stop__request__all, this);
+    bool requested = global_cancel_source_.request_stop(dispatch_threads);
+    global_stop_source_.request_stop();
+    stats_.on_global_stop();
+    return requested;
   }
 
   // Checks if global stop request was sent
   bool stop_requested_all() const noexcept
   {
-    return global_stop_source_.stop_requested();
+    return global_cancel_source_.stop_requested();
+  }
+
+  // Returns a borrowed token observing the global stop request
+  CancellationToken global_token() const noexcept
+  {
+    return global_cancel_source_.get_token();
   }
 
   // Sends stop request to thread `tid` 
   bool request_stop(const std::thread::id& tid)
   {
     std::lock_guard lock(threads_mtx_);
-    if (!threads_.contains(tid))
-    {
-      std::ostringstream oss;
-      oss << tid;
-      throw std::invalid_argument(
-        "Thread with id: " + oss.str() + " does not exist"
-      );
-    }
-    return threads_[tid].request_stop();
+    stats_.on_local_stop();
+    bool requested = lookup(tid).request_stop();
+    PARALLELLAUNCHER_PROBE(stop__request, this, probe_key(tid), requested);
+    return requested;
   }
 
   // Checks if thread `id` was requested to stop
   bool stop_requested(const std::thread::id& tid)
   {
     std::lock_guard lock(threads_mtx_);
-    if (!threads_.contains(tid))
-    {
-      std::ostringstream oss;
-      oss << tid;
-      throw std::invalid_argument(
-        "Thread with id: " + oss.str() + " does not exist"
-      );
-    }    
-    return threads_.at(tid).get_stop_token().stop_requested();
+    return lookup(tid).stop_requested();
   }
 
   // Blocks and attempts to join all the threads, clears dead threads
   void join()
   {
     std::lock_guard lock(threads_mtx_);
-    for (auto& [_, thread] : threads_)
+    std::chrono::steady_clock::time_point held_since;
+    if constexpr (is_profiled_lock_v<LockPolicy>)
     {
-      thread.join();
+      held_since = std::chrono::steady_clock::now();
     }
+    size_t count = threads_.size();
+    PARALLELLAUNCHER_PROBE(join__start, this, count);
+
+    threads_.for_each([this] (ManagedThread_t& managed) {
+      if (managed.thread.joinable())
+      {
+        managed.thread.join();
+      }
+      else if (managed.cached)
+      {
+        managed.cached->wait_idle();
+        thread_cache_.release(managed.cached);
+      }
+      recycle_stop_source(managed.stop_source);
+      recycle_local_source(managed.local_source);
+    });
+    stats_.on_join(count);
     threads_.clear();
+    PARALLELLAUNCHER_PROBE(join__done, this, count);
+
+    if constexpr (is_profiled_lock_v<LockPolicy>)
+    {
+      threads_mtx_.record_hold(LockPolicy::elapsed_ns(held_since));
+    }
   }
 
   // Checks if all threads are running
   bool all_running() const noexcept
   {
-    return (thread_counter_.load(std::memory_order::acquire) >= threads_.size()) && 
-           (threads_.size() != 0);
+    std::lock_guard lock(threads_mtx_);
+    return (running_count() >= threads_.size()) && (threads_.size() != 0);
   }
   // Checks if any thread is running
   bool any_running() const noexcept
   {
-    return thread_counter_.load(std::memory_order::acquire) > 0;
+    return thread_counter_.load() > 0;
   }
 
   // Returns the total number of threads
   size_t total_threads() const noexcept
   {
+    // The reaper may be removing entries concurrently
+    std::lock_guard lock(threads_mtx_);
     return threads_.size();
   }
 
   // Returns count of threads still running
   size_t alive_threads() const noexcept
   {
-    return thread_counter_.load(std::memory_order::acquire);
+    return running_count();
+  }
+
+  // Returns the statistics gathered so far
+  ThreadManagerStats_t stats() const noexcept
+  {
+    ThreadManagerStats_t stats = stats_.snapshot();
+    if constexpr (is_profiled_lock_v<LockPolicy>)
+    {
+      stats.registry_lock = threads_mtx_.stats();
+    }
+    stats.cache_lock = thread_cache_.lock_stats();
+    return stats;
   }
 
 private:
-  std::atomic<uint32_t> thread_counter_{0};
+  // Whether the worker takes CancellationTokens as both tokens, and hence
+  // gets a pooled local source
+  template <typename Callable, typename... Args>
+  static constexpr bool takes_local_cancellation_v =
+    std::is_invocable_v<
+      std::decay_t<Callable>&, CancellationToken, CancellationToken, std::decay_t<Args>&...
+    > &&
+    !std::is_invocable_v<
+      std::decay_t<Callable>&, std::stop_token, CancellationToken, std::decay_t<Args>&...
+    >;
+
+  // Registry entry of a managed thread
+  struct ManagedThread_t
+  {
+    // Requests the local stop the work observes
+    bool request_stop() noexcept
+    {
+      return local_source ? local_source->request_stop() : stop_source.request_stop();
+    }
+
+    bool stop_requested() const noexcept
+    {
+      return local_source ? local_source->stop_requested() : stop_source.stop_requested();
+    }
+
+    // Local stop of work taking a CancellationToken; declared before thread
+    // so that it outlives the join in the destructor
+    std::unique_ptr<CancellationSource> local_source;
+    // Owned thread; empty when the work runs on a cached thread
+    std::jthread thread;
+    // Cached thread running the work, if any
+    ThreadCache::Worker_t* cached = nullptr;
+    // Local stop of the current work; stateless until a thread is assigned,
+    // or while local_source is used instead
+    std::stop_source stop_source{std::nostopstate};
+    // Number of the spawn running the current work
+    uint64_t seq = 0;
+  };
+
+  /**
+   * Launches `worker` on a cached or new thread and registers it; caller
+   * holds threads_mtx_ and has counted the thread in thread_counter_
+   *
+   * @param launched Set once the work runs and owns its count
+   * @returns The id of the thread running the work
+   */
+  template <typename Callable, typename... Args>
+  std::thread::id launch(bool& launched, Callable&& worker, Args&&... args)
+  {
+    // A full registry refuses the work before it runs; once launched, the
+    // work is registered without a way to fail
+    threads_.make_room();
+    constexpr bool local_cancellation = takes_local_cancellation_v<Callable, Args...>;
+    std::unique_ptr<CancellationSource> local_source;
+    if constexpr (local_cancellation)
+    {
+      local_source = take_local_source();
+    }
+    // Claimed here rather than by the work, so that the slot can be given
+    // the stop of the work once it is known
+    HeartbeatSlot_t* beat = heartbeats_ ? heartbeats_->claim() : nullptr;
+
+    std::thread::id tid;
+    auto task = 
+      [
+        this, 
+        seq = ++spawn_seq_,
+        local = local_source.get(),
+        beat,
+        worker = std::forward<Callable>(worker), 
+        ... args = std::forward<Args>(args)
+      ]
+      (std::stop_token local_stoken) mutable {
+        StackSampler* sampler = sampler_.load(std::memory_order::acquire);
+        bool sampled = sampler &&
+                       sampler_attach_.load(std::memory_order::relaxed)(sampler);
+        if (beat)
+        {
+          HeartbeatTable::attach(beat);
+        }
+        PARALLELLAUNCHER_PROBE(
+          worker__start, this, probe_key(std::this_thread::get_id())
+        );
+
+        // Workers accepting a CancellationToken get a borrowed one, the
+        // rest keep receiving a std::stop_token
+        if constexpr (local_cancellation)
+        {
+          worker(
+            local->get_token(),
+            global_cancel_source_.get_token(),
+            args...
+          );
+        }
+        else if constexpr (std::is_invocable_v<
+          std::decay_t<Callable>&,
+          std::stop_token,
+          CancellationToken,
+          std::decay_t<Args>&...
+        >)
+        {
+          worker(
+            local_stoken, 
+            global_cancel_source_.get_token(), 
+            args...
+          );
+        }
+        else
+        {
+          worker(
+            local_stoken, 
+            global_stop_source_.get_token(), 
+            args...
+          );
+        }
+
+        PARALLELLAUNCHER_PROBE(
+          worker__exit, this, probe_key(std::this_thread::get_id())
+        );
+        if (beat)
+        {
+          HeartbeatTable::release(beat);
+        }
+        if (sampled)
+        {
+          sampler_detach_.load(std::memory_order::relaxed)(sampler);
+        }
+        thread_counter_.sub(1);
+
+        if (reaping_.load(std::memory_order::acquire))
+        {
+          retire(std::this_thread::get_id(), seq);
+        }
+        if (completion_fd_.fd.load(std::memory_order::acquire) != -1)
+        {
+          complete(std::this_thread::get_id());
+        }
+    };
+
+    try
+    {
+      if (thread_cache_.enabled())
+      {
+        // Work with a local source never looks at its std::stop_token
+        std::stop_source stop_source = local_cancellation
+                                     ? std::stop_source(std::nostopstate)
+                                     : take_stop_source();
+        // Held until the entry is removed, so the id stays unique meanwhile
+        ThreadCache::Worker_t* cached = thread_cache_.submit(UniqueTask(
+          [task = std::move(task), stoken = stop_source.get_token()] () mutable {
+            task(stoken);
+          }
+        ), true);
+        launched = true;
+        tid = cached->id;
+
+        ManagedThread_t& managed = threads_.emplace(tid);
+        managed.cached = cached;
+        managed.seq = spawn_seq_;
+        managed.stop_source = std::move(stop_source);
+        managed.local_source = std::move(local_source);
+        arm(beat, tid, managed);
+      }
+      else
+      {
+        std::jthread thread(std::move(task));
+        launched = true;
+        tid = thread.get_id();
+
+        ManagedThread_t& managed = threads_.emplace(tid);
+        managed.cached = nullptr;
+        managed.seq = spawn_seq_;
+        managed.stop_source = thread.get_stop_source();
+        managed.local_source = std::move(local_source);
+        managed.thread = std::move(thread);
+        arm(beat, tid, managed);
+      }
+    }
+    catch (...)
+    {
+      // Work that never ran can not hand its slot back itself
+      if (beat && !launched)
+      {
+        HeartbeatTable::release(beat);
+      }
+      recycle_local_source(local_source);
+      throw;
+    }
+
+    return tid;
+  }
+
+  // Starts watching the launched work of `managed` through `beat`, if any
+  static void arm(
+    HeartbeatSlot_t* beat,
+    std::thread::id tid,
+    const ManagedThread_t& managed
+  ) noexcept
+  {
+    if (beat)
+    {
+      HeartbeatTable::arm(beat, tid, managed.stop_source, managed.local_source.get());
+    }
+  }
+
+  // Eventfd of completion_fd(), closed after every thread that may write it
+  struct CompletionFd_t
+  {
+    ~CompletionFd_t()
+    {
+      if (int open_fd = fd.load(std::memory_order::relaxed); open_fd != -1)
+      {
+        close(open_fd);
+      }
+    }
+    std::atomic<int> fd{-1};
+  };
+
+  // Work that returned, for the reaper
+  struct Finished_t
+  {
+    std::thread::id tid;
+    uint64_t seq;
+  };
+
+  // Queues finished work of the calling thread for the reaper
+  void retire(std::thread::id tid, uint64_t seq)
+  {
+    {
+      std::lock_guard lock(finished_mtx_);
+      finished_.push_back({tid, seq});
+    }
+    finished_cv_.notify_one();
+  }
+
+  // Queues a completion of the calling thread and wakes the event loop if
+  // none was pending
+  void complete(std::thread::id tid)
+  {
+    std::lock_guard lock(completions_mtx_);
+    completions_.push_back(tid);
+    if (completions_.size() == 1)
+    {
+      uint64_t one = 1;
+      [[maybe_unused]] ssize_t written = write(
+        completion_fd_.fd.load(std::memory_order::relaxed), &one, sizeof(one)
+      );
+    }
+  }
+
+  // Removes the entries of finished work until stopped, one at a time
+  void reap(std::stop_token stoken)
+  {
+    std::vector<Finished_t> batch;
+    while (!stoken.stop_requested())
+    {
+      {
+        std::unique_lock lock(finished_mtx_);
+        if (!finished_cv_.wait(lock, stoken, [this] { return !finished_.empty(); }))
+        {
+          return;
+        }
+        // Both buffers keep their capacity across swaps
+        batch.swap(finished_);
+      }
+
+      for (const Finished_t& finished : batch)
+      {
+        ManagedThread_t retired;
+        {
+          std::lock_guard lock(threads_mtx_);
+          ManagedThread_t* managed = threads_.find(finished.tid);
+          // The thread may run later work by now, or join() took it already
+          if (managed == nullptr || managed->seq != finished.seq)
+          {
+            continue;
+          }
+          threads_.extract(finished.tid, retired);
+          recycle_stop_source(retired.stop_source);
+          recycle_local_source(retired.local_source);
+          stats_.on_join(1);
+        }
+        // The work returned; the thread exits (or parks) momentarily
+        if (retired.thread.joinable())
+        {
+          retired.thread.join();
+        }
+        else if (retired.cached)
+        {
+          thread_cache_.release(retired.cached);
+        }
+        stats_.on_reap();
+      }
+      batch.clear();
+    }
+  }
+
+  // Scans the heartbeats every quarter deadline until stopped
+  void watch(std::stop_token stoken)
+  {
+    std::mutex mtx;
+    std::condition_variable_any cv;
+    auto interval = std::max<std::chrono::milliseconds>(
+      watchdog_deadline_ / 4, std::chrono::milliseconds(1)
+    );
+
+    std::unique_lock lock(mtx);
+    while (!cv.wait_for(lock, stoken, interval, [] { return false; }) &&
+           !stoken.stop_requested())
+    {
+      size_t stalled = heartbeats_->scan(
+        watchdog_deadline_,
+        [this] (
+          [[maybe_unused]] std::thread::id owner,
+          HeartbeatSlot_t* slot,
+          uint64_t generation
+        ) {
+          stats_.on_stall();
+          PARALLELLAUNCHER_PROBE(worker__stall, this, probe_key(owner));
+          if (watchdog_action_ == WATCHDOG_ACTION_ENM::stop)
+          {
+            // Through the slot, as join() holds the registry while it waits
+            HeartbeatTable::request_stop(slot, generation);
+          }
+        }
+      );
+      stalled_now_.store(stalled, std::memory_order::relaxed);
+    }
+  }
+
+  // Returns the running count, clamped for counter policies whose load()
+  // may momentarily read below zero
+  size_t running_count() const noexcept
+  {
+    return static_cast<size_t>(std::max<int64_t>(thread_counter_.load(), 0));
+  }
+
+  // Returns the entry of `tid`; caller holds threads_mtx_
+  ManagedThread_t& lookup(const std::thread::id& tid)
+  {
+    ManagedThread_t* managed = threads_.find(tid);
+    if (managed == nullptr)
+    {
+      std::ostringstream oss;
+      oss << tid;
+      throw std::invalid_argument(
+        "Thread with id: " + oss.str() + " does not exist"
+      );
+    }
+    return *managed;
+  }
+
+  // Returns a reserved stop state if one is left, else a new one; caller
+  // holds threads_mtx_
+  std::stop_source take_stop_source()
+  {
+    if (spare_stop_sources_.empty())
+    {
+      return std::stop_source();
+    }
+    std::stop_source stop_source = std::move(spare_stop_sources_.back());
+    spare_stop_sources_.pop_back();
+    return stop_source;
+  }
+
+  // Keeps the stop state of finished work for reuse if it was never stopped
+  // and room was reserved; caller holds threads_mtx_
+  void recycle_stop_source(std::stop_source& stop_source) noexcept
+  {
+    if (stop_source.stop_possible() && !stop_source.stop_requested() &&
+        spare_stop_sources_.size() < spare_stop_sources_.capacity())
+    {
+      spare_stop_sources_.push_back(std::move(stop_source));
+    }
+  }
+
+  // Returns a reserved local source if one is left, else a new one; caller
+  // holds threads_mtx_
+  std::unique_ptr<CancellationSource> take_local_source()
+  {
+    if (spare_local_sources_.empty())
+    {
+      return std::make_unique<CancellationSource>();
+    }
+    std::unique_ptr<CancellationSource> source = std::move(spare_local_sources_.back());
+    spare_local_sources_.pop_back();
+    return source;
+  }
+
+  // Re-arms the local source of returned work for reuse if room was
+  // reserved; caller holds threads_mtx_
+  void recycle_local_source(std::unique_ptr<CancellationSource>& source) noexcept
+  {
+    if (source && spare_local_sources_.size() < spare_local_sources_.capacity())
+    {
+      source->reset();
+      spare_local_sources_.push_back(std::move(source));
+    }
+  }
+
+  // Workers update it on start and exit
+  CounterPolicy thread_counter_;
+  CancellationSource global_cancel_source_;
+  // Only handed to workers taking a std::stop_token as global token
   std::stop_source global_stop_source_;
-  std::unordered_map<std::thread::id, std::jthread, std::hash<std::thread::id>> threads_;
-  std::mutex threads_mtx_;
+  // Outlive the threads of threads_ and thread_cache_, which use them; set
+  // under threads_mtx_, where spawns claim the slots
+  std::unique_ptr<HeartbeatTable> heartbeats_;
+  std::chrono::milliseconds watchdog_deadline_{0};
+  WATCHDOG_ACTION_ENM watchdog_action_ = WATCHDOG_ACTION_ENM::flag;
+  std::atomic<size_t> stalled_now_{0};
+  // Numbers spawns; guarded by threads_mtx_
+  uint64_t spawn_seq_ = 0;
+  std::atomic<bool> reaping_{false};
+  // Work finished since the reaper last ran; outlives the threads
+  // reporting to it
+  std::mutex finished_mtx_;
+  std::condition_variable_any finished_cv_;
+  std::vector<Finished_t> finished_;
+  // Completions pending for drain_completions(), likewise outliving the
+  // threads reporting to them
+  CompletionFd_t completion_fd_;
+  std::mutex completions_mtx_;
+  std::vector<std::thread::id> completions_;
+  typename RegistryPolicy::template type<ManagedThread_t> threads_;
+  mutable LockPolicy threads_mtx_;
+  // Unstopped stop states kept by reserve() and join(); guarded by threads_mtx_
+  std::vector<std::stop_source> spare_stop_sources_;
+  // Likewise for local sources, which are re-armed even if stopped
+  std::vector<std::unique_ptr<CancellationSource>> spare_local_sources_;
+  [[no_unique_address]] StatsPolicy stats_;
+  // Attached by each thread around its work, if set, through the hooks
+  // stored before it
+  std::atomic<StackSampler*> sampler_{nullptr};
+  std::atomic<bool (*)(StackSampler*) noexcept> sampler_attach_{nullptr};
+  std::atomic<void (*)(StackSampler*) noexcept> sampler_detach_{nullptr};
+  ThreadCache thread_cache_;
+  // Stopped and joined before anything they use is destroyed
+  std::jthread watchdog_;
+  std::jthread reaper_;
 };
+
+/// @brief ThreadManager with the default policies
+using ThreadManager = BasicThreadManager<>;
@@ -0,0 +1,564 @@
+/**
+ *  ===========================================================================
+ * /                         ThreadManagerPolicies                            /
+ * ===========================================================================
+ *        -- Compile-time building blocks of BasicThreadManager --
+ *
+ * > Registry policies (where managed threads are looked up by id):-
+ *   (+) HashRegistry - std::unordered_map; O(1) lookups. Nodes of cleared
+ *                      entries are kept, up to the reserved count, and reused
+ *                      instead of allocating new ones
+ *   (+) SlotArrayRegistry - Contiguous slots searched linearly; cheapest for
+ *                           a few dozen threads
+ *   (+) FixedRegistry<N> - At most N slots held inline, never allocates;
+ *                          spawning beyond N throws std::length_error
+ *
+ * > Lock policies (guarding the registry):-
+ *   (+) InternalLock - Default; std::mutex, or ProfiledLock<std::mutex> when
+ *                      built with PARALLELLAUNCHER_LOCK_PROFILING
+ *   (+) std::mutex
+ *   (+) ProfiledLock<Lock> - Counts acquisitions and times contention and
+ *                            join()'s hold time (refer LockProfiler.hpp)
+ *   (+) SpinLock - Test-and-test-and-set spinlock for short critical sections
+ *   (+) NullLock - No locking; only valid if a single thread calls the
+ *                  manager's API
+ *
+ * > Counter policies (counting running threads):-
+ *   (+) PerCpuCounter - Sharded per CPU (default, refer PerCpuCounter.hpp)
+ *   (+) AtomicCounter - A single seq_cst atomic
+ *
+ * > Stats policies:-
+ *   (+) NoStats - Compiles the statistics away (default)
+ *   (+) CountingStats - Counts spawns, joins, stop requests, stalls, reaps,
+ *                       restarts and escalations with relaxed atomics
+ *
+ * > Every registry exposes `template <typename Entry> class type` providing
+ *   find(), emplace(), extract(), for_each(), clear(), size(), reserve(),
+ *   capacity() and make_room(). After make_room(), the next emplace() of a
+ *   new id neither throws nor allocates, so a thread can be registered
+ *   once it runs without a way to fail.
+ * > Every stats policy provides the on_*() hooks and snapshot(), which
+ *   returns a ThreadManagerStats_t.
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <LockProfiler.hpp>
+
+
+///  @brief Statistics reported by BasicThreadManager::stats()
+struct ThreadManagerStats_t
+{
+  // Threads handed work through spawn_thread()
+  uint64_t spawned;
+  // Threads waited for by join()
+  uint64_t joined;
+  // Calls to request_stop()
+  uint64_t local_stop_requests;
+  // Calls to request_stop_all()
+  uint64_t global_stop_requests;
+  // Work flagged as stalled by the watchdog
+  uint64_t stalls;
+  // Finished threads removed by the reaper
+  uint64_t reaped;
+  // Restarts of supervised workers after exceptions
+  uint64_t restarts;
+  // Supervised workers that exceeded their restart intensity
+  uint64_t escalations;
+  // Profile of the registry lock (all zero unless it is a ProfiledLock)
+  LockStats_t registry_lock;
+  // Profile of the thread cache's lock (all zero unless InternalLock is
+  // profiled)
+  LockStats_t cache_lock;
+};
+
+/// @brief Registry policy backed by std::unordered_map
+struct HashRegistry
+{
+  template <typename Entry>
+  class type
+  {
+  public:
+    Entry* find(const std::thread::id& tid) noexcept
+    {
+      auto it = entries_.find(tid);
+      return (it == entries_.end()) ? nullptr : &it->second;
+    }
+
+    // Returns the entry of `tid`, default constructing it if missing
+    Entry& emplace(const std::thread::id& tid)
+    {
+      if (Entry* entry = find(tid))
+      {
+        return *entry;
+      }
+      if (spare_.empty())
+      {
+        return entries_[tid];
+      }
+      auto node = std::move(spare_.back());
+      spare_.pop_back();
+      node.key() = tid;
+      return entries_.insert(std::move(node)).position->second;
+    }
+
+    // Prepares a node and buckets for the next emplace() of a new id
+    void make_room()
+    {
+      if (static_cast<float>(entries_.size() + 1) >
+          static_cast<float>(entries_.bucket_count()) * entries_.max_load_factor())
+      {
+        entries_.reserve(entries_.size() + 1);
+      }
+      if (spare_.empty())
+      {
+        spare_.push_back(entries_.extract(
+          entries_.try_emplace(std::thread::id()).first
+        ));
+      }
+    }
+
+    // Moves the entry of `tid` into `out` and removes it; false if missing
+    bool extract(const std::thread::id& tid, Entry& out)
+    {
+      auto node = entries_.extract(tid);
+      if (node.empty())
+      {
+        return false;
+      }
+      out = std::move(node.mapped());
+      if (spare_.size() < spare_.capacity())
+      {
+        node.mapped() = Entry();
+        spare_.push_back(std::move(node));
+      }
+      return true;
+    }
+
+    template <typename Visitor>
+    void for_each(Visitor&& visitor)
+    {
+      for (auto& [_, entry] : entries_)
+      {
+        visitor(entry);
+      }
+    }
+
+    void clear() noexcept
+    {
+      while (!entries_.empty() && spare_.size() < spare_.capacity())
+      {
+        auto node = entries_.extract(entries_.begin());
+        node.mapped() = Entry();
+        spare_.push_back(std::move(node));
+      }
+      entries_.clear();
+    }
+
+    size_t size() const noexcept
+    {
+      return entries_.size();
+    }
+
+    // Also preallocates `limit` nodes, less the ones in use
+    void reserve(size_t limit)
+    {
+      entries_.max_load_factor(1.0F);
+      entries_.rehash(limit);
+
+      spare_.reserve(limit);
+      while (entries_.size() + spare_.size() < limit)
+      {
+        // Any key works, each node is extracted before the next one is made
+        spare_.push_back(entries_.extract(
+          entries_.try_emplace(std::thread::id()).first
+        ));
+      }
+    }
+
+    size_t capacity() const noexcept
+    {
+      return entries_.bucket_count();
+    }
+
+  private:
+    using Map = std::unordered_map<std::thread::id, Entry, std::hash<std::thread::id>>;
+
+    Map entries_;
+    // Detached nodes reused by emplace()
+    std::vector<typename Map::node_type> spare_;
+  };
+};
+
+/// @brief Registry policy backed by a contiguous array searched linearly
+struct SlotArrayRegistry
+{
+  template <typename Entry>
+  class type
+  {
+  public:
+    Entry* find(const std::thread::id& tid) noexcept
+    {
+      for (auto& [id, entry] : slots_)
+      {
+        if (id == tid)
+        {
+          return &entry;
+        }
+      }
+      return nullptr;
+    }
+
+    Entry& emplace(const std::thread::id& tid)
+    {
+      if (Entry* entry = find(tid))
+      {
+        return *entry;
+      }
+      return slots_.emplace_back(
+        std::piecewise_construct,
+        std::forward_as_tuple(tid),
+        std::forward_as_tuple()
+      ).second;
+    }
+
+    void make_room()
+    {
+      if (slots_.size() == slots_.capacity())
+      {
+        slots_.reserve(std::max<size_t>(2 * slots_.capacity(), 4));
+      }
+    }
+
+    bool extract(const std::thread::id& tid, Entry& out)
+    {
+      for (auto& slot : slots_)
+      {
+        if (slot.first == tid)
+        {
+          out = std::move(slot.second);
+          if (&slot != &slots_.back())
+          {
+            slot = std::move(slots_.back());
+          }
+          slots_.pop_back();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    template <typename Visitor>
+    void for_each(Visitor&& visitor)
+    {
+      for (auto& [_, entry] : slots_)
+      {
+        visitor(entry);
+      }
+    }
+
+    void clear() noexcept
+    {
+      slots_.clear();
+    }
+
+    size_t size() const noexcept
+    {
+      return slots_.size();
+    }
+
+    void reserve(size_t limit)
+    {
+      slots_.reserve(limit);
+    }
+
+    size_t capacity() const noexcept
+    {
+      return slots_.capacity();
+    }
+
+  private:
+    std::vector<std::pair<std::thread::id, Entry>> slots_;
+  };
+};
+
+/// @brief Registry policy holding at most `N` entries inline
+template <size_t N>
+struct FixedRegistry
+{
+  template <typename Entry>
+  class type
+  {
+  public:
+    Entry* find(const std::thread::id& tid) noexcept
+    {
+      for (size_t i = 0; i < size_; i++)
+      {
+        if (ids_[i] == tid)
+        {
+          return &entries_[i];
+        }
+      }
+      return nullptr;
+    }
+
+    Entry& emplace(const std::thread::id& tid)
+    {
+      if (Entry* entry = find(tid))
+      {
+        return *entry;
+      }
+      if (size_ == N)
+      {
+        throw std::length_error("FixedRegistry is full");
+      }
+      ids_[size_] = tid;
+      return entries_[size_++];
+    }
+
+    void make_room()
+    {
+      if (size_ == N)
+      {
+        throw std::length_error("FixedRegistry is full");
+      }
+    }
+
+    bool extract(const std::thread::id& tid, Entry& out)
+    {
+      for (size_t i = 0; i < size_; i++)
+      {
+        if (ids_[i] == tid)
+        {
+          out = std::move(entries_[i]);
+          size_--;
+          if (i != size_)
+          {
+            ids_[i] = ids_[size_];
+            entries_[i] = std::move(entries_[size_]);
+          }
+          ids_[size_] = std::thread::id();
+          entries_[size_] = Entry();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    template <typename Visitor>
+    void for_each(Visitor&& visitor)
+    {
+      for (size_t i = 0; i < size_; i++)
+      {
+        visitor(entries_[i]);
+      }
+    }
+
+    void clear() noexcept
+    {
+      for (size_t i = 0; i < size_; i++)
+      {
+        entries_[i] = Entry();
+        ids_[i] = std::thread::id();
+      }
+      size_ = 0;
+    }
+
+    size_t size() const noexcept
+    {
+      return size_;
+    }
+
+    void reserve(size_t limit)
+    {
+      if (limit > N)
+      {
+        throw std::length_error("FixedRegistry cannot grow beyond its capacity");
+      }
+    }
+
+    size_t capacity() const noexcept
+    {
+      return N;
+    }
+
+  private:
+    std::array<std::thread::id, N> ids_{};
+    std::array<Entry, N> entries_{};
+    size_t size_ = 0;
+  };
+};
+
+/// @brief Test-and-test-and-set spinlock (Lockable)
+class SpinLock
+{
+public:
+  void lock() noexcept
+  {
+    while (locked_.exchange(true, std::memory_order::acquire))
+    {
+      while (locked_.load(std::memory_order::relaxed))
+      {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#else
+        std::this_thread::yield();
+#endif
+      }
+    }
+  }
+
+  bool try_lock() noexcept
+  {
+    return !locked_.load(std::memory_order::relaxed) &&
+           !locked_.exchange(true, std::memory_order::acquire);
+  }
+
+  void unlock() noexcept
+  {
+    locked_.store(false, std::memory_order::release);
+  }
+
+private:
+  std::atomic<bool> locked_{false};
+};
+
+/// @brief Lock policy that does not lock; for single-threaded API use only
+struct NullLock
+{
+  void lock() noexcept
+  { }
+  bool try_lock() noexcept
+  {
+    return true;
+  }
+  void unlock() noexcept
+  { }
+};
+
+/// @brief Counter policy using a single seq_cst atomic
+class AtomicCounter
+{
+public:
+  void add(int64_t n = 1) noexcept
+  {
+    value_.fetch_add(n, std::memory_order::seq_cst);
+  }
+
+  void sub(int64_t n = 1) noexcept
+  {
+    value_.fetch_sub(n, std::memory_order::seq_cst);
+  }
+
+  int64_t load() const noexcept
+  {
+    return value_.load(std::memory_order::acquire);
+  }
+
+private:
+  std::atomic<int64_t> value_{0};
+};
+
+/// @brief Stats policy compiling every statistic away
+struct NoStats
+{
+  static constexpr bool enabled = false;
+
+  void on_spawn(uint64_t = 1) noexcept
+  { }
+  void on_join(uint64_t) noexcept
+  { }
+  void on_local_stop() noexcept
+  { }
+  void on_global_stop() noexcept
+  { }
+  void on_stall() noexcept
+  { }
+  void on_reap() noexcept
+  { }
+  void on_restart() noexcept
+  { }
+  void on_escalation() noexcept
+  { }
+
+  ThreadManagerStats_t snapshot() const noexcept
+  {
+    return {};
+  }
+};
+
+/// @brief Stats policy counting events with relaxed atomics
+class CountingStats
+{
+public:
+  static constexpr bool enabled = true;
+
+  void on_spawn(uint64_t n = 1) noexcept
+  {
+    spawned_.fetch_add(n, std::memory_order::relaxed);
+  }
+  void on_join(uint64_t n) noexcept
+  {
+    joined_.fetch_add(n, std::memory_order::relaxed);
+  }
+  void on_local_stop() noexcept
+  {
+    local_stops_.fetch_add(1, std::memory_order::relaxed);
+  }
+  void on_global_stop() noexcept
+  {
+    global_stops_.fetch_add(1, std::memory_order::relaxed);
+  }
+  void on_stall() noexcept
+  {
+    stalls_.fetch_add(1, std::memory_order::relaxed);
+  }
+  void on_reap() noexcept
+  {
+    reaped_.fetch_add(1, std::memory_order::relaxed);
+  }
+  void on_restart() noexcept
+  {
+    restarts_.fetch_add(1, std::memory_order::relaxed);
+  }
+  void on_escalation() noexcept
+  {
+    escalations_.fetch_add(1, std::memory_order::relaxed);
+  }
+
+  ThreadManagerStats_t snapshot() const noexcept
+  {
+    ThreadManagerStats_t stats{};
+    stats.spawned = spawned_.load(std::memory_order::relaxed);
+    stats.joined = joined_.load(std::memory_order::relaxed);
+    stats.local_stop_requests = local_stops_.load(std::memory_order::relaxed);
+    stats.global_stop_requests = global_stops_.load(std::memory_order::relaxed);
+    stats.stalls = stalls_.load(std::memory_order::relaxed);
+    stats.reaped = reaped_.load(std::memory_order::relaxed);
+    stats.restarts = restarts_.load(std::memory_order::relaxed);
+    stats.escalations = escalations_.load(std::memory_order::relaxed);
+    return stats;
+  }
+
+private:
+  std::atomic<uint64_t> spawned_{0};
+  std::atomic<uint64_t> joined_{0};
+  std::atomic<uint64_t> local_stops_{0};
+  std::atomic<uint64_t> global_stops_{0};
+  std::atomic<uint64_t> stalls_{0};
+  std::atomic<uint64_t> reaped_{0};
+  std::atomic<uint64_t> restarts_{0};
+  std::atomic<uint64_t> escalations_{0};
+};
@@ -0,0 +1,625 @@
+/**
+ *  ===========================================================================
+ * /                              TimerService                                /
+ * ===========================================================================
+ *      -- Delayed and periodic tasks on managed threads, one timer thread --
+ *
+ * > TimerService keeps timers in a hierarchical timing wheel served by a
+ *   single thread sleeping on a timerfd, and runs each expired timer's
+ *   callback on a thread spawned through the ThreadManager
+ *
+ * > Utilities aside from the class:-
+ *   (+) TimerId_t - Identifies a scheduled timer
+ *
+ * > The class has the following public methods:-
+ *   (+) Constructor (<thread manager>[, <tick>]) (enables the reaper of
+ *                   the manager unless it runs already)
+ *
+ *   (+) TimerId_t schedule_after(<delay>, <callback>[, <stop token>])
+ *              - Runs `callback(local token, global token)` once, `delay`
+ *                from now
+ *   (+) TimerId_t schedule_every(<period>, <callback>[, <stop token>])
+ *              - Runs `callback` every `period`, the first time `period`
+ *                from now
+ *   (+) bool cancel(TimerId_t id) - Drops a timer before its next run;
+ *                                   false if it was gone already
+ *   (+) void shutdown() - Drops every timer and waits for running callbacks
+ *   (+) size_t pending() - Returns the number of scheduled timers
+ *   (+) uint64_t skipped() - Returns the number of periodic runs skipped
+ *
+ * > The wheel has WHEEL_LEVELS levels of WHEEL_SLOTS slots; a level covers
+ *   WHEEL_SLOTS times the span of the one below, so with the default 1ms
+ *   tick the levels span 64ms, 4s, 4min and 4.6h (later timers wait in the
+ *   last level and are re-filed). Scheduling and expiring are O(1); a timer
+ *   moves down at most once per level.
+ * > The timerfd is armed for the next tick with anything to do, found
+ *   through one occupancy bitmap per level, so an idle service never wakes.
+ * > Timers are cancelled through cancel(), through the stop token passed
+ *   when scheduling, and all at once by a global stop request on the
+ *   manager, which also stops the service. A cancelled timer never runs
+ *   again, but a run already started completes; callbacks should honour
+ *   their local and global tokens like any worker.
+ * > A periodic callback never overlaps with itself: a run due while the
+ *   previous one is still going is skipped, as are runs missed while the
+ *   service fell behind.
+ * > The timer thread belongs to the service rather than the manager, so a
+ *   join() on the manager never waits for it. Runs due after a global stop
+ *   are not spawned at all.
+ * > Every run spawns a thread through the manager, and the reaper removes
+ *   its entry once the run returns, so periodic timers do not grow the
+ *   registry until the next join(); enable the thread cache as well for
+ *   frequent timers. The manager must outlive the service. A callback
+ *   escaping with an exception terminates the process.
+ * > TimerService is an alias of BasicTimerService over ThreadManager; a
+ *   BasicTimerService<M> runs over any BasicThreadManager M whose lock
+ *   policy allows calls from several threads (the timer thread spawns the
+ *   runs).
+ */
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <Cancellation.hpp>
+#include <ThreadManager.hpp>
+
+
+/// @brief Identifies a timer of a TimerService
+using TimerId_t = uint64_t;
+
+/// @brief Runs delayed and periodic callbacks on threads of a
+///        BasicThreadManager
+template <typename Manager = ThreadManager>
+class BasicTimerService
+{
+public:
+  // Magic number: Levels of the wheel, and slots per level (one bit each in
+  // an occupancy bitmap)
+  static constexpr size_t WHEEL_LEVELS = 4UL;
+  static constexpr size_t WHEEL_SLOTS = 64UL;
+
+  using Callback = std::function<void(std::stop_token, CancellationToken)>;
+
+private:
+  // Bits of a tick consumed by each level
+  static constexpr unsigned LEVEL_BITS = std::countr_zero(WHEEL_SLOTS);
+  // Sentinel for "no tick"
+  static constexpr uint64_t NEVER = UINT64_MAX;
+
+  struct Timer_t
+  {
+    TimerId_t id;
+    // Tick of the next run
+    uint64_t expiry;
+    // Ticks between runs; 0 for one-shot timers
+    uint64_t period;
+    Callback callback;
+    std::stop_token cancel_token;
+    bool cancelled = false;
+    // Set while a run of the timer is in flight
+    std::atomic<bool> running{false};
+  };
+
+  using Slot_t = std::vector<std::shared_ptr<Timer_t>>;
+
+  // Stops the service on a global stop request
+  struct Waker_t
+  {
+    void operator() () const noexcept
+    {
+      service->stop_loop();
+    }
+    BasicTimerService* service;
+  };
+
+public:
+  BasicTimerService(const BasicTimerService&) = delete;
+  BasicTimerService& operator= (const BasicTimerService&) = delete;
+  BasicTimerService(BasicTimerService&&) = delete;
+  BasicTimerService& operator= (BasicTimerService&&) = delete;
+
+  BasicTimerService() = delete;
+
+  /**
+   * Creates the timerfd, enables the reaper of `manager` and starts the
+   * timer thread
+   *
+   * @param manager Manager spawning the callbacks; must outlive the service
+   * @param tick Resolution of the timers
+   */
+  explicit BasicTimerService(
+    Manager& manager,
+    std::chrono::milliseconds tick = std::chrono::milliseconds(1)
+  ) : manager_(manager),
+      tick_(tick),
+      start_(std::chrono::steady_clock::now()),
+      timer_fd_(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)),
+      stop_callback_(manager.global_token(), Waker_t{this})
+  {
+    if (tick.count() <= 0)
+    {
+      close_fd();
+      throw std::invalid_argument("TimerService needs a positive tick");
+    }
+    if (timer_fd_ == -1)
+    {
+      throw std::system_error(errno, std::system_category());
+    }
+
+    try
+    {
+      if (!manager_.reaper_enabled())
+      {
+        try
+        {
+          manager_.enable_reaper();
+        }
+        catch (const std::logic_error&)
+        {
+          // Enabled concurrently, e.g. by another service
+        }
+      }
+
+      loop_running_ = true;
+      loop_thread_ = std::jthread([this, global = manager_.global_token()] {
+        timer_loop(global);
+
+        std::lock_guard lock(mtx_);
+        loop_running_ = false;
+        done_cv_.notify_all();
+      });
+    }
+    catch (...)
+    {
+      close_fd();
+      throw;
+    }
+  }
+
+  ~BasicTimerService()
+  {
+    shutdown();
+    // The timer thread may still be leaving timer_loop()
+    loop_thread_.join();
+    close_fd();
+  }
+
+  /**
+   * Runs `callback` once after `delay`
+   *
+   * @param delay Time until the run, rounded up to whole ticks
+   * @param callback Invoked with the local and global tokens on a managed
+   *                 thread
+   * @param cancel Drops the timer once a stop is requested through it
+   * @returns The id of the timer
+   */
+  TimerId_t schedule_after(
+    std::chrono::milliseconds delay,
+    Callback callback,
+    std::stop_token cancel = {}
+  )
+  {
+    return schedule(delay, 0, std::move(callback), std::move(cancel));
+  }
+
+  /**
+   * Runs `callback` every `period`, starting `period` from now
+   *
+   * @param period Time between runs, rounded up to whole ticks
+   * @param callback Invoked with the local and global tokens on a managed
+   *                 thread
+   * @param cancel Drops the timer once a stop is requested through it
+   * @returns The id of the timer
+   */
+  TimerId_t schedule_every(
+    std::chrono::milliseconds period,
+    Callback callback,
+    std::stop_token cancel = {}
+  )
+  {
+    if (period.count() <= 0)
+    {
+      throw std::invalid_argument("A periodic timer needs a positive period");
+    }
+    return schedule(period, ticks(period), std::move(callback), std::move(cancel));
+  }
+
+  // Drops timer `id` before its next run; false if it is not scheduled
+  bool cancel(TimerId_t id)
+  {
+    std::lock_guard lock(mtx_);
+    auto it = index_.find(id);
+    if (it == index_.end())
+    {
+      return false;
+    }
+    // The wheel lets go of the timer once its slot comes up
+    it->second->cancelled = true;
+    index_.erase(it);
+    return true;
+  }
+
+  // Drops every timer and waits for the timer thread and running callbacks
+  void shutdown() noexcept
+  {
+    stop_loop();
+
+    std::unique_lock lock(mtx_);
+    done_cv_.wait(lock, [this] { return !loop_running_ && in_flight_ == 0; });
+    for (auto& [id, timer] : index_)
+    {
+      timer->cancelled = true;
+    }
+    index_.clear();
+  }
+
+  // Returns the number of scheduled timers
+  size_t pending()
+  {
+    std::lock_guard lock(mtx_);
+    return index_.size();
+  }
+
+  // Returns the number of periodic runs skipped
+  uint64_t skipped() const noexcept
+  {
+    return skipped_.load(std::memory_order::relaxed);
+  }
+
+private:
+  // Returns `duration` in whole ticks, rounded up and at least one
+  uint64_t ticks(std::chrono::milliseconds duration) const noexcept
+  {
+    int64_t count = (duration.count() + tick_.count() - 1) / tick_.count();
+    return static_cast<uint64_t>(std::max<int64_t>(count, 1));
+  }
+
+  // Returns the tick the clock is in
+  uint64_t current_tick() const noexcept
+  {
+    return static_cast<uint64_t>((std::chrono::steady_clock::now() - start_) / tick_);
+  }
+
+  TimerId_t schedule(
+    std::chrono::milliseconds delay,
+    uint64_t period,
+    Callback callback,
+    std::stop_token cancel
+  )
+  {
+    auto timer = std::make_shared<Timer_t>();
+    timer->period = period;
+    timer->callback = std::move(callback);
+    timer->cancel_token = std::move(cancel);
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    uint64_t now = static_cast<uint64_t>(elapsed / tick_);
+    // Rounded up, so timers never run early
+    uint64_t due = std::max(now + 1, static_cast<uint64_t>(
+      (elapsed + delay + tick_ - std::chrono::nanoseconds(1)) / tick_
+    ));
+
+    std::lock_guard lock(mtx_);
+    if (stopping_)
+    {
+      throw std::logic_error("TimerService is shut down");
+    }
+    if (std::ranges::all_of(occupied_, [] (uint64_t bits) { return bits == 0; }))
+    {
+      // Nothing is filed, so the idle wheel can skip ahead to the clock
+      now_tick_ = std::max(now_tick_, now);
+    }
+    timer->id = ++last_id_;
+    // The wheel may lag behind the clock until the timer thread catches up
+    timer->expiry = std::max(due, now_tick_ + 1);
+    index_.emplace(timer->id, timer);
+    insert(std::move(timer));
+    arm();
+    return last_id_;
+  }
+
+  // Files `timer` into the slot matching its distance from now_tick_
+  void insert(std::shared_ptr<Timer_t> timer)
+  {
+    uint64_t expiry = std::max(timer->expiry, now_tick_ + 1);
+    uint64_t delta = expiry - now_tick_;
+    size_t level = 0;
+    while (level + 1 < WHEEL_LEVELS && delta >= (1ULL << (LEVEL_BITS * (level + 1))))
+    {
+      level++;
+    }
+    // Beyond the wheel: waits in the furthest slot and is re-filed from there
+    uint64_t span = 1ULL << (LEVEL_BITS * WHEEL_LEVELS);
+    if (delta >= span)
+    {
+      expiry = now_tick_ + span - 1;
+    }
+
+    size_t slot = (expiry >> (LEVEL_BITS * level)) & (WHEEL_SLOTS - 1);
+    wheel_[level][slot].push_back(std::move(timer));
+    occupied_[level] |= 1ULL << slot;
+  }
+
+  // Returns the first tick after now_tick_ with a slot to expire or move
+  // down, NEVER if the wheel is empty
+  uint64_t next_event() const noexcept
+  {
+    uint64_t next = NEVER;
+    for (size_t level = 0; level < WHEEL_LEVELS; level++)
+    {
+      if (occupied_[level] == 0)
+      {
+        continue;
+      }
+      unsigned shift = LEVEL_BITS * static_cast<unsigned>(level);
+      uint64_t position = now_tick_ >> shift;
+      // Slots after the current one come first, the current one last
+      uint64_t ahead = std::rotr(occupied_[level], static_cast<int>((position + 1) % WHEEL_SLOTS));
+      uint64_t event = (position + 1 + static_cast<uint64_t>(std::countr_zero(ahead))) << shift;
+      next = std::min(next, event);
+    }
+    return next;
+  }
+
+  // Moves the wheel to tick `target`, collecting timers due on the way
+  void advance(uint64_t target, std::vector<std::shared_ptr<Timer_t>>& due)
+  {
+    for (;;)
+    {
+      uint64_t tick = next_event();
+      if (tick > target)
+      {
+        now_tick_ = std::max(now_tick_, target);
+        return;
+      }
+      now_tick_ = tick;
+
+      // Higher levels move down first, so timers landing on this very tick
+      // expire with it
+      for (size_t level = WHEEL_LEVELS - 1; level > 0; level--)
+      {
+        unsigned shift = LEVEL_BITS * static_cast<unsigned>(level);
+        if ((tick & ((1ULL << shift) - 1)) != 0)
+        {
+          continue;
+        }
+        size_t slot = (tick >> shift) & (WHEEL_SLOTS - 1);
+        Slot_t moving;
+        moving.swap(wheel_[level][slot]);
+        occupied_[level] &= ~(1ULL << slot);
+        for (auto& timer : moving)
+        {
+          if (!timer->cancelled)
+          {
+            insert(std::move(timer));
+          }
+        }
+      }
+
+      size_t slot = tick & (WHEEL_SLOTS - 1);
+      Slot_t expiring;
+      expiring.swap(wheel_[0][slot]);
+      occupied_[0] &= ~(1ULL << slot);
+      for (auto& timer : expiring)
+      {
+        expire(std::move(timer), target, due);
+      }
+    }
+  }
+
+  // Hands an expired timer over for a run and re-files periodic ones
+  void expire(
+    std::shared_ptr<Timer_t> timer,
+    uint64_t target,
+    std::vector<std::shared_ptr<Timer_t>>& due
+  )
+  {
+    if (timer->cancelled)
+    {
+      return;
+    }
+    if (timer->cancel_token.stop_requested())
+    {
+      timer->cancelled = true;
+      index_.erase(timer->id);
+      return;
+    }
+
+    if (timer->period == 0)
+    {
+      index_.erase(timer->id);
+      due.push_back(std::move(timer));
+      return;
+    }
+
+    uint64_t next = timer->expiry + timer->period;
+    if (next <= target)
+    {
+      // Runs missed while behind are skipped rather than run back to back
+      uint64_t missed = (target - next) / timer->period + 1;
+      skipped_.fetch_add(missed, std::memory_order::relaxed);
+      next += missed * timer->period;
+    }
+    timer->expiry = next;
+    due.push_back(timer);
+    insert(std::move(timer));
+  }
+
+  // Arms the timerfd for the next event, or disarms it; caller holds mtx_
+  void arm() noexcept
+  {
+    if (stopping_)
+    {
+      // Left firing for the timer thread to notice the stop
+      return;
+    }
+    uint64_t next = next_event();
+    if (next == armed_tick_)
+    {
+      return;
+    }
+    armed_tick_ = next;
+
+    itimerspec spec{};
+    if (next != NEVER)
+    {
+      auto at = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        (start_ + tick_ * static_cast<int64_t>(next)).time_since_epoch()
+      ).count();
+      spec.it_value.tv_sec = static_cast<time_t>(at / 1'000'000'000);
+      spec.it_value.tv_nsec = static_cast<long>(at % 1'000'000'000);
+    }
+    timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+  }
+
+  // Serves the wheel until stopped
+  void timer_loop(CancellationToken global)
+  {
+    std::vector<std::shared_ptr<Timer_t>> due;
+    for (;;)
+    {
+      uint64_t expirations;
+      if (read(timer_fd_, &expirations, sizeof(expirations)) == -1 && errno != EINTR)
+      {
+        return;
+      }
+
+      {
+        std::lock_guard lock(mtx_);
+        if (stopping_ || global.stop_requested())
+        {
+          return;
+        }
+        // The fd fired, so it is no longer armed
+        armed_tick_ = NEVER;
+        advance(current_tick(), due);
+        arm();
+      }
+
+      for (auto& timer : due)
+      {
+        dispatch(std::move(timer), global);
+      }
+      due.clear();
+    }
+  }
+
+  // Runs `timer`'s callback on a managed thread
+  void dispatch(std::shared_ptr<Timer_t> timer, const CancellationToken& global)
+  {
+    if (timer->running.exchange(true, std::memory_order::acq_rel))
+    {
+      skipped_.fetch_add(1, std::memory_order::relaxed);
+      return;
+    }
+
+    {
+      std::lock_guard lock(mtx_);
+      // The run would be stopped anyway, and the spawn would wait for a
+      // join() of the manager following the stop
+      if (stopping_ || global.stop_requested())
+      {
+        timer->running.store(false, std::memory_order::release);
+        return;
+      }
+      ++in_flight_;
+    }
+    try
+    {
+      manager_.spawn_thread(
+        [this, timer] (std::stop_token local, CancellationToken global) {
+          timer->callback(local, global);
+          timer->running.store(false, std::memory_order::release);
+          retire();
+        }
+      );
+    }
+    catch (...)
+    {
+      timer->running.store(false, std::memory_order::release);
+      retire();
+    }
+  }
+
+  // Accounts for a finished run
+  void retire() noexcept
+  {
+    std::lock_guard lock(mtx_);
+    if (--in_flight_ == 0)
+    {
+      done_cv_.notify_all();
+    }
+  }
+
+  // Stops scheduling and wakes the timer thread
+  void stop_loop() noexcept
+  {
+    std::lock_guard lock(mtx_);
+    if (stopping_)
+    {
+      return;
+    }
+    stopping_ = true;
+
+    // Fires right away; the timer thread then sees the stop
+    itimerspec spec{};
+    spec.it_value.tv_nsec = 1;
+    timerfd_settime(timer_fd_, 0, &spec, nullptr);
+  }
+
+  void close_fd() noexcept
+  {
+    if (timer_fd_ != -1)
+    {
+      close(timer_fd_);
+      timer_fd_ = -1;
+    }
+  }
+
+  Manager& manager_;
+  std::chrono::milliseconds tick_;
+  std::chrono::steady_clock::time_point start_;
+  int timer_fd_;
+  std::atomic<uint64_t> skipped_{0};
+
+  // Guards everything below
+  std::mutex mtx_;
+  std::condition_variable done_cv_;
+  std::array<std::array<Slot_t, WHEEL_SLOTS>, WHEEL_LEVELS> wheel_;
+  std::array<uint64_t, WHEEL_LEVELS> occupied_{};
+  std::unordered_map<TimerId_t, std::shared_ptr<Timer_t>> index_;
+  uint64_t now_tick_ = 0;
+  uint64_t armed_tick_ = NEVER;
+  TimerId_t last_id_ = 0;
+  size_t in_flight_ = 0;
+  bool loop_running_ = false;
+  bool stopping_ = false;
+
+  CancellationCallback<Waker_t> stop_callback_;
+  std::jthread loop_thread_;
+};
+
+/// @brief TimerService over a ThreadManager with the default policies
+using TimerService = BasicTimerService<>;
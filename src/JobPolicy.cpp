@@ -0,0 +1,157 @@
+#include <JobPolicy.hpp>
+
+#include <charconv>
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <linux/ioprio.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+  // Magic number: Bounds of /proc/<pid>/oom_score_adj
+  constexpr int OOM_SCORE_ADJ_MIN = -1000;
+  constexpr int OOM_SCORE_ADJ_MAX = 1000;
+  // Magic number: Bounds of nice values
+  constexpr int NICE_MIN = -20;
+  constexpr int NICE_MAX = 19;
+  // Magic number: Levels within an I/O class
+  constexpr int IO_LEVELS = 8;
+
+  // Writes `length` bytes of `text` to /proc/self/oom_score_adj; only
+  // async-signal-safe calls
+  int write_oom_score_adj(const char* text, size_t length) noexcept
+  {
+    int fd = open("/proc/self/oom_score_adj", O_WRONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+      return errno;
+    }
+    int error = 0;
+    if (write(fd, text, length) == -1)
+    {
+      error = errno;
+    }
+    close(fd);
+    return error;
+  }
+}
+
+JobPolicy::JobPolicy(JobPolicyConfig_t config)
+  : config_(config)
+{
+  if (config_.oom_score_adj &&
+      (*config_.oom_score_adj < OOM_SCORE_ADJ_MIN || *config_.oom_score_adj > OOM_SCORE_ADJ_MAX))
+  {
+    throw std::invalid_argument(
+      "oom_score_adj out of range: " + std::to_string(*config_.oom_score_adj)
+    );
+  }
+  if (config_.nice < NICE_MIN || config_.nice > NICE_MAX)
+  {
+    throw std::invalid_argument("nice out of range: " + std::to_string(config_.nice));
+  }
+  if (config_.io_level < 0 || config_.io_level >= IO_LEVELS)
+  {
+    throw std::invalid_argument("io_level out of range: " + std::to_string(config_.io_level));
+  }
+
+  if (config_.oom_score_adj)
+  {
+    // In range, so it always fits and leaves room for the newline
+    char* end = std::to_chars(
+      oom_text_, oom_text_ + OOM_TEXT_SIZE - 1, *config_.oom_score_adj
+    ).ptr;
+    *end++ = '\n';
+    oom_length_ = static_cast<size_t>(end - oom_text_);
+  }
+
+  switch (config_.io_class)
+  {
+    case IO_CLASS_ENM::realtime:
+      ioprio_ = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_RT, config_.io_level);
+      break;
+    case IO_CLASS_ENM::best_effort:
+      ioprio_ = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, config_.io_level);
+      break;
+    case IO_CLASS_ENM::idle:
+      // The idle class has no levels
+      ioprio_ = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0);
+      break;
+    case IO_CLASS_ENM::inherit:
+      break;
+  }
+}
+
+int JobPolicy::prepare_child() const noexcept
+{
+  // Only raw syscalls are used here, which are async-signal-safe
+
+  // Nice first, so that a knob failing later never leaves the child with
+  // the supervisor's boost; and before the policy, since SCHED_IDLE
+  // ignores it while SCHED_BATCH weighs by it
+  if (setpriority(PRIO_PROCESS, 0, config_.nice) == -1)
+  {
+    return errno;
+  }
+
+  if (oom_length_ > 0)
+  {
+    int error = write_oom_score_adj(oom_text_, oom_length_);
+    if (error != 0)
+    {
+      return error;
+    }
+  }
+
+  if (config_.io_class != IO_CLASS_ENM::inherit &&
+      syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, ioprio_) == -1)
+  {
+    return errno;
+  }
+
+  if (config_.cpu_policy != CPU_POLICY_ENM::inherit)
+  {
+    int policy = SCHED_OTHER;
+    if (config_.cpu_policy == CPU_POLICY_ENM::batch)
+    {
+      policy = SCHED_BATCH;
+    }
+    else if (config_.cpu_policy == CPU_POLICY_ENM::idle)
+    {
+      policy = SCHED_IDLE;
+    }
+    sched_param param{};
+    if (sched_setscheduler(0, policy, &param) == -1)
+    {
+      return errno;
+    }
+  }
+
+  return 0;
+}
+
+bool JobPolicy::prioritize_thread(int nice)
+{
+  if (nice < NICE_MIN || nice > NICE_MAX)
+  {
+    throw std::invalid_argument("nice out of range: " + std::to_string(nice));
+  }
+
+  // Nice values are per thread on Linux, hence the thread id
+  if (setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), nice) == -1)
+  {
+    if (errno == EPERM || errno == EACCES)
+    {
+      return false;
+    }
+    throw std::system_error(errno, std::system_category());
+  }
+  return true;
+}
@@ -0,0 +1,240 @@
+#include <MemoryPressure.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace
+{
+  // Opens `path` and registers a "<kind> <stall> <window>" trigger on it
+  int open_trigger(
+    const std::string& path,
+    const char* kind,
+    std::chrono::microseconds stall,
+    std::chrono::microseconds window
+  )
+  {
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1)
+    {
+      throw std::system_error(errno, std::system_category(), path);
+    }
+
+    std::string trigger = std::string(kind) + " " + std::to_string(stall.count()) +
+                          " " + std::to_string(window.count());
+    // The kernel expects the terminating NUL as part of the write
+    if (write(fd, trigger.c_str(), trigger.size() + 1) == -1)
+    {
+      int error = errno;
+      close(fd);
+      throw std::system_error(error, std::system_category(), path + ": " + trigger);
+    }
+    return fd;
+  }
+
+  void close_fd(int& fd) noexcept
+  {
+    if (fd != -1)
+    {
+      close(fd);
+      fd = -1;
+    }
+  }
+}
+
+MemoryPressure::MemoryPressure(MemoryPressureConfig_t config, CancellationToken global)
+  : config_(std::move(config))
+{
+  try
+  {
+    some_fd_ = open_trigger(config_.path, "some", config_.throttle_stall, config_.window);
+    full_fd_ = open_trigger(config_.path, "full", config_.suspend_stall, config_.window);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ == -1)
+    {
+      throw std::system_error(errno, std::system_category());
+    }
+
+    stop_callback_.emplace(global, Waker_t{this});
+    monitor_running_ = true;
+    monitor_thread_ = std::jthread([this, global] { monitor(global); });
+  }
+  catch (...)
+  {
+    monitor_running_ = false;
+    stop_callback_.reset();
+    close_fd(some_fd_);
+    close_fd(full_fd_);
+    close_fd(wake_fd_);
+    throw;
+  }
+}
+
+MemoryPressure::~MemoryPressure()
+{
+  shutdown();
+  // The monitor may still be leaving monitor()
+  monitor_thread_.join();
+  // Waits for a running callback, which may still write to wake_fd_
+  stop_callback_.reset();
+  close_fd(some_fd_);
+  close_fd(full_fd_);
+  close_fd(wake_fd_);
+}
+
+void MemoryPressure::track(pid_t pid)
+{
+  std::lock_guard lock(mtx_);
+  jobs_.push_back({pid, false});
+}
+
+void MemoryPressure::untrack(pid_t pid)
+{
+  std::lock_guard lock(mtx_);
+  std::erase_if(jobs_, [pid] (const Job_t& job) { return job.pid == pid; });
+}
+
+bool MemoryPressure::wait_admitted(std::stop_token stoken)
+{
+  std::unique_lock lock(mtx_);
+  return level_cv_.wait(lock, stoken, [this] { return admitted(); });
+}
+
+void MemoryPressure::apply(PRESSURE_LEVEL_ENM level)
+{
+  std::lock_guard lock(mtx_);
+  if (level == PRESSURE_LEVEL_ENM::suspend)
+  {
+    // Newest running jobs first
+    size_t batch = config_.suspend_batch;
+    for (auto it = jobs_.rbegin(); it != jobs_.rend() && batch > 0; ++it)
+    {
+      if (!it->stopped && kill(it->pid, SIGSTOP) == 0)
+      {
+        it->stopped = true;
+        batch--;
+      }
+    }
+  }
+  else
+  {
+    resume_all();
+  }
+
+  level_.store(level, std::memory_order::release);
+  level_cv_.notify_all();
+}
+
+size_t MemoryPressure::suspended()
+{
+  std::lock_guard lock(mtx_);
+  return static_cast<size_t>(std::count_if(jobs_.begin(), jobs_.end(), [] (const Job_t& job) {
+    return job.stopped;
+  }));
+}
+
+void MemoryPressure::shutdown() noexcept
+{
+  stopping_.store(true, std::memory_order::release);
+  wake();
+
+  std::unique_lock lock(mtx_);
+  level_cv_.wait(lock, [this] { return !monitor_running_; });
+  resume_all();
+}
+
+void MemoryPressure::monitor(CancellationToken global)
+{
+  pollfd pfds[] = {
+    {some_fd_, POLLPRI, 0},
+    {full_fd_, POLLPRI, 0},
+    {wake_fd_, POLLIN, 0},
+  };
+  auto last_event = std::chrono::steady_clock::now();
+
+  while (!stopping_.load(std::memory_order::acquire) && !global.stop_requested())
+  {
+    // Sleeps for good while there is nothing to step down from
+    int timeout = -1;
+    if (level() != PRESSURE_LEVEL_ENM::normal)
+    {
+      auto left = config_.settle - std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - last_event
+      );
+      timeout = static_cast<int>(std::max<int64_t>(left.count(), 0));
+    }
+
+    int ready = poll(pfds, 3, timeout);
+    if (ready == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      break;
+    }
+    if ((pfds[0].revents | pfds[1].revents) & (POLLERR | POLLNVAL))
+    {
+      // The triggers went away (e.g. the cgroup was removed)
+      break;
+    }
+
+    if (pfds[1].revents & POLLPRI)
+    {
+      last_event = std::chrono::steady_clock::now();
+      apply(PRESSURE_LEVEL_ENM::suspend);
+    }
+    else if (pfds[0].revents & POLLPRI)
+    {
+      last_event = std::chrono::steady_clock::now();
+      if (level() == PRESSURE_LEVEL_ENM::normal)
+      {
+        apply(PRESSURE_LEVEL_ENM::throttle);
+      }
+    }
+    else if (ready == 0)
+    {
+      // Settled: one level down per quiet period
+      last_event = std::chrono::steady_clock::now();
+      apply(level() == PRESSURE_LEVEL_ENM::suspend
+            ? PRESSURE_LEVEL_ENM::throttle
+            : PRESSURE_LEVEL_ENM::normal);
+    }
+  }
+
+  // Without a monitor nothing would ever clear the pressure again
+  std::lock_guard lock(mtx_);
+  resume_all();
+  level_.store(PRESSURE_LEVEL_ENM::normal, std::memory_order::release);
+  monitor_running_ = false;
+  level_cv_.notify_all();
+}
+
+void MemoryPressure::resume_all() noexcept
+{
+  for (Job_t& job : jobs_)
+  {
+    if (job.stopped)
+    {
+      kill(job.pid, SIGCONT);
+      job.stopped = false;
+    }
+  }
+}
+
+void MemoryPressure::wake() noexcept
+{
+  if (wake_fd_ != -1)
+  {
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(wake_fd_, &one, sizeof(one));
+  }
+}
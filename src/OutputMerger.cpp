@@ -0,0 +1,302 @@
+#include <OutputMerger.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+#include <cerrno>
+#include <climits>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace
+{
+#ifdef IOV_MAX
+  constexpr size_t IOV_LIMIT = IOV_MAX;
+#else
+  constexpr size_t IOV_LIMIT = 1024UL;
+#endif
+  // Every piece takes at most two iovecs: prefix and line(s)
+  constexpr size_t PIECE_LIMIT = IOV_LIMIT / 2;
+}
+
+OutputMerger::OutputMerger(
+  int fd,
+  OutputMode_t mode,
+  size_t batch_bytes,
+  std::chrono::milliseconds flush_interval
+) : fd_(fd),
+    mode_(mode),
+    batch_bytes_(batch_bytes ? batch_bytes : 1UL),
+    flush_interval_(flush_interval)
+{
+  arena_.reserve(batch_bytes_);
+  pieces_.reserve(PIECE_LIMIT);
+  iov_.reserve(IOV_LIMIT);
+  flusher_ = std::jthread([this] (std::stop_token stoken) {
+    flush_due(stoken);
+  });
+}
+
+OutputMerger::~OutputMerger()
+{
+  flusher_.request_stop();
+  flusher_.join();
+
+  // Destructor must not throw
+  try
+  {
+    std::lock_guard lock(mtx_);
+    for (auto& source : sources_)
+    {
+      if (source.open)
+      {
+        source.open = false;
+        emit(source, source.pending, true);
+      }
+    }
+    flush_locked();
+  }
+  catch (...)
+  { }
+}
+
+uint32_t OutputMerger::add_source(std::string tag)
+{
+  std::lock_guard lock(mtx_);
+  if (sources_.size() >= UINT32_MAX)
+  {
+    throw std::length_error("Too many output sources");
+  }
+
+  Source_t source;
+  if (mode_.tag)
+  {
+    source.prefix = std::move(tag);
+    source.prefix += '\t';
+  }
+  source.open = true;
+  sources_.push_back(std::move(source));
+
+  return static_cast<uint32_t>(sources_.size() - 1);
+}
+
+void OutputMerger::write(uint32_t source, const char* data, size_t length)
+{
+  std::lock_guard lock(mtx_);
+  Source_t& src = lookup(source);
+  std::string_view chunk(data, length);
+
+  if (!mode_.line_buffer)
+  {
+    src.pending.append(chunk);
+  }
+  else if (size_t last_nl = chunk.rfind('\n'); last_nl == std::string_view::npos)
+  {
+    src.pending.append(chunk);
+  }
+  else if (src.pending.empty())
+  {
+    src.pending.assign(chunk.substr(last_nl + 1));
+    emit(src, chunk.substr(0, last_nl + 1), false);
+  }
+  else
+  {
+    // Taken out of `pending` first, so a failing flush cannot emit it twice
+    std::string lines;
+    lines.swap(src.pending);
+    lines.append(chunk.substr(0, last_nl + 1));
+    src.pending.assign(chunk.substr(last_nl + 1));
+    emit(src, lines, false);
+  }
+
+  if (
+    !pieces_.empty() &&
+    std::chrono::steady_clock::now() - batch_started_ >= flush_interval_
+  )
+  {
+    flush_locked();
+  }
+}
+
+void OutputMerger::close_source(uint32_t source)
+{
+  std::lock_guard lock(mtx_);
+  Source_t& src = lookup(source);
+
+  std::string rest;
+  rest.swap(src.pending);
+  src.open = false;
+  // The prefix stays alive; pieces of the pending batch still refer to it
+  emit(src, rest, true);
+}
+
+void OutputMerger::flush()
+{
+  std::lock_guard lock(mtx_);
+  flush_locked();
+}
+
+void OutputMerger::emit(Source_t& source, std::string_view data, bool all)
+{
+  uint32_t id = static_cast<uint32_t>(&source - sources_.data());
+
+  while (!data.empty())
+  {
+    if (pieces_.empty())
+    {
+      batch_started_ = std::chrono::steady_clock::now();
+      batch_cv_.notify_one();
+    }
+
+    // Without a prefix the whole run can be a single piece
+    size_t end = data.size();
+    if (!source.prefix.empty())
+    {
+      size_t nl = data.find('\n');
+      end = (nl == std::string_view::npos) ? data.size() : nl + 1;
+    }
+
+    std::string_view line = data.substr(0, end);
+    data.remove_prefix(end);
+
+    pieces_.push_back({id, arena_.size(), line.size()});
+    arena_.append(line);
+    if (all && data.empty() && line.back() != '\n')
+    {
+      arena_ += '\n';
+      pieces_.back().length++;
+    }
+
+  }
+
+  // Only flushed once all of `data` is in the batch, so a failing writev
+  // leaves it there exactly once
+  if (arena_.size() >= batch_bytes_ || pieces_.size() >= PIECE_LIMIT)
+  {
+    flush_locked();
+  }
+}
+
+void OutputMerger::flush_locked()
+{
+  if (pieces_.empty())
+  {
+    return;
+  }
+
+  iov_.clear();
+  for (const auto& piece : pieces_)
+  {
+    if (piece.source != RAW_PIECE)
+    {
+      const std::string& prefix = sources_[piece.source].prefix;
+      if (!prefix.empty())
+      {
+        iov_.push_back({const_cast<char*>(prefix.data()), prefix.size()});
+      }
+    }
+    iov_.push_back({arena_.data() + piece.offset, piece.length});
+  }
+
+  struct iovec* iov = iov_.data();
+  int iovcnt = static_cast<int>(iov_.size());
+  while (iovcnt > 0)
+  {
+    // A single write may have pushed the batch beyond IOV_MAX entries
+    ssize_t n = writev(fd_, iov, std::min(iovcnt, static_cast<int>(IOV_LIMIT)));
+    if (n == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+      {
+        struct pollfd pfd = {fd_, POLLOUT, 0};
+        poll(&pfd, 1, -1);
+        continue;
+      }
+      int error = errno;
+      keep_unwritten(iov, iovcnt);
+      throw std::system_error(error, std::system_category());
+    }
+
+    syscalls_.fetch_add(1, std::memory_order::relaxed);
+    bytes_written_.fetch_add(n, std::memory_order::relaxed);
+
+    // Skip what was written, resuming partially written entries
+    size_t written = static_cast<size_t>(n);
+    while (iovcnt > 0 && written >= iov->iov_len)
+    {
+      written -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if (iovcnt > 0)
+    {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+      iov->iov_len -= written;
+    }
+  }
+
+  pieces_.clear();
+  arena_.clear();
+}
+
+void OutputMerger::keep_unwritten(const struct iovec* iov, int iovcnt)
+{
+  // Prefixes are copied as well, as they may be partially written
+  std::string rest;
+  for (int i = 0; i < iovcnt; i++)
+  {
+    rest.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+  }
+
+  pieces_.clear();
+  arena_.assign(rest);
+  pieces_.push_back({RAW_PIECE, 0, arena_.size()});
+}
+
+void OutputMerger::flush_due(std::stop_token stoken)
+{
+  std::unique_lock lock(mtx_);
+  while (!stoken.stop_requested())
+  {
+    if (pieces_.empty())
+    {
+      batch_cv_.wait(lock, stoken, [this] { return !pieces_.empty(); });
+      continue;
+    }
+
+    batch_cv_.wait_until(lock, stoken, batch_started_ + flush_interval_, [] { return false; });
+    if (stoken.stop_requested() || pieces_.empty() ||
+        std::chrono::steady_clock::now() < batch_started_ + flush_interval_)
+    {
+      // Flushed meanwhile, or a newer batch started
+      continue;
+    }
+
+    try
+    {
+      flush_locked();
+    }
+    catch (...)
+    {
+      // Retried after another interval; write() and flush() report it
+      batch_started_ = std::chrono::steady_clock::now();
+    }
+  }
+}
+
+OutputMerger::Source_t& OutputMerger::lookup(uint32_t source)
+{
+  if (source >= sources_.size() || !sources_[source].open)
+  {
+    throw std::invalid_argument(
+      "Output source " + std::to_string(source) + " is not open"
+    );
+  }
+  return sources_[source];
+}
@@ -0,0 +1,267 @@
+#include <SharedInputs.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+  // Seals applied to every shared input
+  constexpr int READ_ONLY_SEALS = F_SEAL_WRITE | F_SEAL_SHRINK |
+                                  F_SEAL_GROW | F_SEAL_SEAL;
+
+  // Closes the descriptor on scope exit unless released
+  struct FdGuard
+  {
+    int fd;
+    ~FdGuard()
+    {
+      if (fd != -1)
+      {
+        close(fd);
+      }
+    }
+    int release() noexcept
+    {
+      int ret = fd;
+      fd = -1;
+      return ret;
+    }
+  };
+
+  // Copies `size` bytes from `src` into `dst` with in-kernel copies where
+  // possible, falling back to a read/write loop
+  void copy_contents(int src, int dst, size_t size)
+  {
+    size_t copied = 0;
+    while (copied < size)
+    {
+      ssize_t n = copy_file_range(src, nullptr, dst, nullptr, size - copied, 0);
+      if (n > 0)
+      {
+        copied += static_cast<size_t>(n);
+        continue;
+      }
+      if (n == 0)
+      {
+        throw std::runtime_error("Input was truncated while being loaded");
+      }
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      if (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+          errno == EOPNOTSUPP)
+      {
+        break;
+      }
+      throw std::system_error(errno, std::system_category());
+    }
+
+    char buffer[1 << 16];
+    while (copied < size)
+    {
+      ssize_t n = pread(
+        src, buffer, std::min(sizeof(buffer), size - copied), copied
+      );
+      if (n == -1 && errno == EINTR)
+      {
+        continue;
+      }
+      if (n == -1)
+      {
+        throw std::system_error(errno, std::system_category());
+      }
+      if (n == 0)
+      {
+        throw std::runtime_error("Input was truncated while being loaded");
+      }
+      for (ssize_t off = 0; off < n;)
+      {
+        ssize_t w = pwrite(dst, buffer + off, n - off, copied + off);
+        if (w == -1 && errno == EINTR)
+        {
+          continue;
+        }
+        if (w == -1)
+        {
+          throw std::system_error(errno, std::system_category());
+        }
+        off += w;
+      }
+      copied += static_cast<size_t>(n);
+    }
+  }
+
+  // Returns the environment variable advertising input `name`
+  std::string env_key(const std::string& name)
+  {
+    std::string key = "PL_SHARED_";
+    for (const char c : name)
+    {
+      key += std::isalnum(static_cast<unsigned char>(c))
+        ? static_cast<char>(std::toupper(static_cast<unsigned char>(c)))
+        : '_';
+    }
+    return key;
+  }
+}
+
+SharedInputs::~SharedInputs()
+{
+  for (const int memfd : fds_)
+  {
+    close(memfd);
+  }
+}
+
+int SharedInputs::add(const std::string& name, const std::string& path)
+{
+  FdGuard src{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (src.fd == -1)
+  {
+    throw std::system_error(errno, std::system_category(), path);
+  }
+
+  struct stat st;
+  if (fstat(src.fd, &st) == -1)
+  {
+    throw std::system_error(errno, std::system_category(), path);
+  }
+  if (!S_ISREG(st.st_mode))
+  {
+    throw std::invalid_argument(path + " is not a regular file");
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  FdGuard memfd{create(name, size)};
+  copy_contents(src.fd, memfd.fd, size);
+
+  return seal(name, memfd.release(), size);
+}
+
+int SharedInputs::add_buffer(
+  const std::string& name,
+  const void* data,
+  size_t size
+)
+{
+  FdGuard memfd{create(name, size)};
+
+  const char* bytes = static_cast<const char*>(data);
+  for (size_t off = 0; off < size;)
+  {
+    ssize_t w = pwrite(memfd.fd, bytes + off, size - off, off);
+    if (w == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (w == -1)
+    {
+      throw std::system_error(errno, std::system_category());
+    }
+    off += static_cast<size_t>(w);
+  }
+
+  return seal(name, memfd.release(), size);
+}
+
+std::vector<std::string> SharedInputs::environment() const
+{
+  std::vector<std::string> env;
+  env.reserve(inputs_.size());
+
+  for (const auto& [name, input] : inputs_)
+  {
+    env.push_back(env_key(name) + "=/proc/self/fd/" + std::to_string(input.fd));
+  }
+
+  return env;
+}
+
+void SharedInputs::prepare_child() const noexcept
+{
+  // Only fcntl is used here, which is async-signal-safe
+  for (const int memfd : fds_)
+  {
+    int flags = fcntl(memfd, F_GETFD);
+    if (flags != -1)
+    {
+      fcntl(memfd, F_SETFD, flags & ~FD_CLOEXEC);
+    }
+  }
+}
+
+int SharedInputs::create(const std::string& name, size_t size)
+{
+  if (inputs_.contains(name))
+  {
+    throw std::invalid_argument("Shared input " + name + " already exists");
+  }
+  std::string key = env_key(name);
+  if (auto it = env_keys_.find(key); it != env_keys_.end())
+  {
+    throw std::invalid_argument(
+      "Shared inputs " + it->second + " and " + name + " both map to " + key
+    );
+  }
+
+  int memfd = memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (memfd == -1)
+  {
+    throw std::system_error(errno, std::system_category());
+  }
+
+  if (ftruncate(memfd, static_cast<off_t>(size)) == -1)
+  {
+    int errc = errno;
+    close(memfd);
+    throw std::system_error(errc, std::system_category());
+  }
+
+  return memfd;
+}
+
+int SharedInputs::seal(const std::string& name, int memfd, size_t size)
+{
+  FdGuard guard{memfd};
+  if (fcntl(memfd, F_ADD_SEALS, READ_ONLY_SEALS) == -1)
+  {
+    throw std::system_error(errno, std::system_category());
+  }
+
+  // Reserve first so that a failing push_back cannot leak the registration;
+  // until then the guard still owns the memfd
+  fds_.reserve(fds_.size() + 1);
+  auto input = inputs_.emplace(name, Input_t{memfd, size}).first;
+  try
+  {
+    env_keys_.emplace(env_key(name), name);
+  }
+  catch (...)
+  {
+    inputs_.erase(input);
+    throw;
+  }
+  fds_.push_back(guard.release());
+
+  return memfd;
+}
+
+const SharedInputs::Input_t& SharedInputs::lookup(const std::string& name) const
+{
+  auto it = inputs_.find(name);
+  if (it == inputs_.end())
+  {
+    throw std::invalid_argument("Shared input " + name + " does not exist");
+  }
+  return it->second;
+}
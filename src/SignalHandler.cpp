@@ -1,197 +1,293 @@
 #include <SignalHandler.hpp>
+#include <Probes.hpp>
 
-std::atomic_flag SignalHandler::instance_exists_ = ATOMIC_FLAG_INIT;
-std::atomic<uint32_t> SignalHandler::sig_flags_[SIGFLAGN] = {};
+std::atomic<SignalHandlerBase*> SignalHandlerBase::subscribers_[MAX_SUBSCRIBERS] = {};
+std::atomic<uint32_t> SignalHandlerBase::in_flight_{0};
 
-SignalHandler::SignalHandler(
-  std::initializer_list<int> signal_list,
-  int flags,
-  bool throw_sig_error
-)
+std::mutex SignalHandlerBase::registry_mtx_;
+std::condition_variable_any SignalHandlerBase::registry_cv_;
+uint32_t SignalHandlerBase::install_count_[NSIG] = {};
+struct sigaction SignalHandlerBase::old_actions_[NSIG] = {};
+sigset_t SignalHandlerBase::dispatch_mask_ = {};
+uint64_t SignalHandlerBase::dispatch_generation_ = 0;
+size_t SignalHandlerBase::subscriber_count_ = 0;
+std::jthread SignalHandlerBase::dispatch_thread_;
+
+SignalHandlerBase::SignalHandlerBase() noexcept
 {
-  if (instance_exists_.test_and_set(std::memory_order::acq_rel))
+  sigemptyset(&sigmask_);
+  sigemptyset(&installed_);
+  for (auto& flags : sig_flags_)
   {
-    throw std::logic_error("Instance of SignalHandler already exists");
+    flags.store(0, std::memory_order::relaxed);
   }
+}
 
-  for (const int signal : signal_list)
+SignalHandlerBase::~SignalHandlerBase()
+{
+  if (slot_ != MAX_SUBSCRIBERS)
   {
-    if (signal <= 0 || signal >= NSIG)
+    // seq_cst pairs with the handler's increment and load: either the handler
+    // misses this instance, or this sees the handler in flight
+    subscribers_[slot_].store(nullptr, std::memory_order::seq_cst);
+    while (in_flight_.load(std::memory_order::seq_cst) != 0)
     {
-      instance_exists_.clear(std::memory_order::release);
-      throw std::invalid_argument(
-        std::to_string(signal) + " is not a valid signal"
-      );
+      std::this_thread::yield();
     }
   }
 
-  sigemptyset(&sigmask_);
-  
-  for (const int signal : signal_list)
+  std::jthread retired;
   {
-    sigaddset(&sigmask_, signal);
+    std::lock_guard lock(registry_mtx_);
+
+    sigset_t unblock;
+    sigemptyset(&unblock);
+    for (int sig = 1; sig < NSIG; sig++)
+    {
+      if (sigismember(&installed_, sig) == 1 && --install_count_[sig] == 0)
+      {
+        sigaction(sig, &old_actions_[sig], nullptr);
+        sigdelset(&dispatch_mask_, sig);
+      }
+      // Signals still held by other subscribers stay blocked
+      if (sigismember(&sigmask_, sig) == 1 && install_count_[sig] == 0)
+      {
+        sigaddset(&unblock, sig);
+      }
+    }
+    pthread_sigmask(SIG_UNBLOCK, &unblock, nullptr);
+
+    if (slot_ != MAX_SUBSCRIBERS && --subscriber_count_ == 0)
+    {
+      retired = std::move(dispatch_thread_);
+      retired.request_stop();
+    }
+    dispatch_generation_++;
+  }
+  registry_cv_.notify_all();
+
+  // Destructor must not throw
+  try
+  {
+    if (retired.joinable())
+    {
+      retired.join();
+    }
+  }
+  catch (...)
+  { }
+
+  if (int fd = event_fd_.load(std::memory_order::relaxed); fd != -1)
+  {
+    close(fd);
+  }
+}
+
+int SignalHandlerBase::event_fd()
+{
+  std::lock_guard lock(registry_mtx_);
+  int fd = event_fd_.load(std::memory_order::relaxed);
+  if (fd == -1)
+  {
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd == -1)
+    {
+      throw std::system_error(errno, std::system_category());
+    }
+    event_fd_.store(fd, std::memory_order::release);
   }
-  
+  return fd;
+}
+
+void SignalHandlerBase::block_signals()
+{
   if (int errc = pthread_sigmask(SIG_BLOCK, &sigmask_, nullptr))   // Only EFAULT possible
   {
     pthread_sigmask(SIG_UNBLOCK, &sigmask_, nullptr);
-    instance_exists_.clear(std::memory_order::release);
     throw std::system_error(errc, std::system_category());
   }
+}
 
-  // Reserve space in the map for exactly the number of old handlers required
-  old_handlers_.max_load_factor(1.0F);
-  old_handlers_.rehash(signal_list.size());
-
-  for (const int signal : signal_list)
+bool SignalHandlerBase::install(int sig, int flags)
+{
+  std::lock_guard lock(registry_mtx_);
+  if (sigismember(&installed_, sig) == 1)
+  {
+    return true;
+  }
+  if (install_count_[sig] == 0)
   {
-    struct sigaction sa_struct, old_sa_struct;
+    struct sigaction sa_struct;
     std::memset(&sa_struct, 0, sizeof(sa_struct));
     sa_struct.sa_flags = flags | SA_SIGINFO;
     sa_struct.sa_sigaction = handler_callback;
 
-    if (
-      (sigaction(signal, &sa_struct, &old_sa_struct) == -1) &&
-      (throw_sig_error)
-    )
+    if (sigaction(sig, &sa_struct, &old_actions_[sig]) == -1)
     {
-      restore_actions();
-      instance_exists_.clear(std::memory_order::release);
-      throw std::system_error(errno, std::system_category());
+      return false;
+    }
+    sigaddset(&dispatch_mask_, sig);
+    dispatch_generation_++;
+  }
+  install_count_[sig]++;
+  sigaddset(&installed_, sig);
+  interest_[flag_index(sig)] |= signal_bitmask(sig);
+  return true;
+}
+
+void SignalHandlerBase::subscribe()
+{
+  {
+    std::lock_guard lock(registry_mtx_);
+    size_t slot = 0;
+    while (slot < MAX_SUBSCRIBERS &&
+           subscribers_[slot].load(std::memory_order::relaxed) != nullptr)
+    {
+      slot++;
+    }
+    if (slot == MAX_SUBSCRIBERS)
+    {
+      throw std::length_error("Too many SignalHandler subscribers");
     }
 
-    old_handlers_[signal] = old_sa_struct;
+    if (subscriber_count_ == 0)
+    {
+      dispatch_thread_ = std::jthread(dispatcher);
+    }
+    subscriber_count_++;
+    slot_ = slot;
+    // interest_ is published along with the pointer
+    subscribers_[slot_].store(this, std::memory_order::release);
   }
+  registry_cv_.notify_all();
+}
+
+void SignalHandlerBase::handler_callback(int sig, siginfo_t*, void*) noexcept
+{
+  // write() below may clobber errno of the interrupted code
+  int saved_errno = errno;
+  in_flight_.fetch_add(1, std::memory_order::seq_cst);
+  PARALLELLAUNCHER_PROBE(signal__enter, sig);
 
-  sig_flags_[SIG_FLAGS_ENM::OS_sigs].store(0, std::memory_order::release);
-  sig_flags_[SIG_FLAGS_ENM::RT_sigs].store(0, std::memory_order::release);
-  sig_flags_[SIG_FLAGS_ENM::reserved].store(0, std::memory_order::release);
+  SIG_FLAGS_ENM flagenm = flag_index(sig);
+  uint32_t bit = signal_bitmask(sig);
+  [[maybe_unused]] uint32_t notified = 0;
+  for (auto& slot : subscribers_)
+  {
+    SignalHandlerBase* subscriber = slot.load(std::memory_order::seq_cst);
+    if (subscriber == nullptr || !(subscriber->interest_[flagenm] & bit))
+    {
+      continue;
+    }
+    subscriber->sig_flags_[flagenm].fetch_or(bit, std::memory_order::release);
+    notified++;
+    if (int fd = subscriber->event_fd_.load(std::memory_order::acquire); fd != -1)
+    {
+      uint64_t one = 1;
+      [[maybe_unused]] ssize_t written = write(fd, &one, sizeof(one));
+    }
+  }
 
-  dispatch_thread_ = std::jthread(
-    dispatcher,
-    std::ref(dispatch_mtx_),
-    std::ref(dispatch_cv_),
-    &sigmask_
-  );
+  PARALLELLAUNCHER_PROBE(signal__exit, sig, notified);
+  in_flight_.fetch_sub(1, std::memory_order::release);
+  errno = saved_errno;
 }
 
-SignalHandler::SignalHandler(
-  std::initializer_list<std::pair<int, int>> initialiser_list,
-  bool throw_sig_error
-)
+void SignalHandlerBase::dispatcher(std::stop_token stoken) noexcept
 {
-  if (instance_exists_.test_and_set(std::memory_order::acq_rel))
+  /**
+   * Is designed to keep the thread waiting to be interrupted by sigaction
+   * This eliminates the "hijacking" behaviour of sigaction. The thread keeps
+   * exactly the installed signals unblocked as subscribers come and go
+   */
+
+  std::unique_lock lock(registry_mtx_);
+  uint64_t applied = dispatch_generation_ - 1;
+  while (!stoken.stop_requested())
   {
-    throw std::logic_error("Instance of SignalHandler already exists");
+    if (applied != dispatch_generation_)
+    {
+      applied = dispatch_generation_;
+      sigset_t blocked;
+      sigfillset(&blocked);
+      for (int sig = 1; sig < NSIG; sig++)
+      {
+        if (sigismember(&dispatch_mask_, sig) == 1)
+        {
+          sigdelset(&blocked, sig);
+        }
+      }
+      pthread_sigmask(SIG_SETMASK, &blocked, nullptr);
+    }
+    registry_cv_.wait(lock, stoken, [&applied] {
+      return applied != dispatch_generation_;
+    });
   }
+}
 
-  for (const auto [signal, _] : initialiser_list)
+SignalHandler::SignalHandler(
+  std::initializer_list<int> signal_list,
+  int flags,
+  bool throw_sig_error
+)
+{
+  for (const int signal : signal_list)
   {
     if (signal <= 0 || signal >= NSIG)
     {
-      instance_exists_.clear(std::memory_order::release);
       throw std::invalid_argument(
         std::to_string(signal) + " is not a valid signal"
       );
     }
   }
 
-  sigemptyset(&sigmask_);
-  
-  for (const auto [signal, _] : initialiser_list)
+  for (const int signal : signal_list)
   {
     sigaddset(&sigmask_, signal);
   }
-  
-  if (int errc = pthread_sigmask(SIG_BLOCK, &sigmask_, nullptr))   // Only EFAULT possible
-  {
-    pthread_sigmask(SIG_UNBLOCK, &sigmask_, nullptr);
-    instance_exists_.clear(std::memory_order::release);
-    throw std::system_error(errc, std::system_category());
-  }
 
-  // Reserve space in the map for exactly the number of old handlers required
-  old_handlers_.max_load_factor(1.0F);
-  old_handlers_.rehash(initialiser_list.size());
+  block_signals();
 
-  for (const auto [signal, flags] : initialiser_list)
+  for (const int signal : signal_list)
   {
-    struct sigaction sa_struct, old_sa_struct;
-    std::memset(&sa_struct, 0, sizeof(sa_struct));
-    sa_struct.sa_flags = flags | SA_SIGINFO;
-    sa_struct.sa_sigaction = handler_callback;
-
-    if (
-      (sigaction(signal, &sa_struct, &old_sa_struct) == -1) &&
-      (throw_sig_error)
-    )
+    if (!install(signal, flags) && throw_sig_error)
     {
-      restore_actions();
-      instance_exists_.clear(std::memory_order::release);
       throw std::system_error(errno, std::system_category());
     }
-
-    old_handlers_[signal] = old_sa_struct;
   }
 
-  sig_flags_[SIG_FLAGS_ENM::OS_sigs].store(0, std::memory_order::release);
-  sig_flags_[SIG_FLAGS_ENM::RT_sigs].store(0, std::memory_order::release);
-  sig_flags_[SIG_FLAGS_ENM::reserved].store(0, std::memory_order::release);
-
-  dispatch_thread_ = std::jthread(
-    dispatcher,
-    std::ref(dispatch_mtx_),
-    std::ref(dispatch_cv_),
-    &sigmask_
-  );
+  subscribe();
 }
 
-void SignalHandler::handler_callback(int sig, siginfo_t* info, void* ucontext) noexcept
+SignalHandler::SignalHandler(
+  std::initializer_list<std::pair<int, int>> initialiser_list,
+  bool throw_sig_error
+)
 {
-  if (sig < 32) 
-  {
-    sig_flags_[SIG_FLAGS_ENM::OS_sigs].fetch_or(
-      signal_bitmask(sig),
-      std::memory_order::release
-    );
-    return;
-  }
-  if (sig < 64)
-  {  
-    sig_flags_[SIG_FLAGS_ENM::RT_sigs].fetch_or(
-      signal_bitmask(sig),
-      std::memory_order::release
-    );
-    return;
-  }
-  // Path reserved for future expansion
-  [[unlikely]] sig_flags_[SIG_FLAGS_ENM::reserved].fetch_or(
-    signal_bitmask(sig),
-    std::memory_order::release
-  );
-}
-
-SignalHandler::~SignalHandler()
-{ 
-  restore_actions();
-
+  for (const auto& [signal, _] : initialiser_list)
   {
-    std::lock_guard lock(dispatch_mtx_);
-    dispatch_thread_.request_stop();
+    if (signal <= 0 || signal >= NSIG)
+    {
+      throw std::invalid_argument(
+        std::to_string(signal) + " is not a valid signal"
+      );
+    }
   }
-  dispatch_cv_.notify_one();
 
-  // Destructor must not throw
-  try
+  for (const auto& [signal, _] : initialiser_list)
   {
-    dispatch_thread_.join();
+    sigaddset(&sigmask_, signal);
   }
-  catch (...)
-  { }
 
-  sig_flags_[SIG_FLAGS_ENM::OS_sigs].store(0, std::memory_order::release);
-  sig_flags_[SIG_FLAGS_ENM::RT_sigs].store(0, std::memory_order::release);
-  sig_flags_[SIG_FLAGS_ENM::reserved].store(0, std::memory_order::release);
+  block_signals();
 
-  instance_exists_.clear(std::memory_order::release);
-}
\ No newline at end of file
+  for (const auto& [signal, flags] : initialiser_list)
+  {
+    if (!install(signal, flags) && throw_sig_error)
+    {
+      throw std::system_error(errno, std::system_category());
+    }
+  }
+
+  subscribe();
+}
@@ -0,0 +1,330 @@
+#include <StackSampler.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <cerrno>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+// Older glibc only exposes the thread id of a sigevent through its union
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+constinit thread_local StackSampler::ThreadBuffer_t* StackSampler::current_ = nullptr;
+std::atomic<bool> StackSampler::installed_{false};
+
+namespace
+{
+  // Returns a printable name for the code at `pc`
+  std::string symbolize(uintptr_t pc)
+  {
+    char text[64];
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(pc), &info) == 0)
+    {
+      std::snprintf(text, sizeof(text), "0x%lx", static_cast<unsigned long>(pc));
+      return text;
+    }
+    if (info.dli_sname)
+    {
+      int status = 0;
+      char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+      std::string name = (status == 0) ? demangled : info.dli_sname;
+      std::free(demangled);
+      return name;
+    }
+
+    const char* module = info.dli_fname ? std::strrchr(info.dli_fname, '/') : nullptr;
+    module = module ? module + 1 : (info.dli_fname ? info.dli_fname : "?");
+    std::snprintf(
+      text, sizeof(text), "+0x%lx",
+      static_cast<unsigned long>(pc - reinterpret_cast<uintptr_t>(info.dli_fbase))
+    );
+    return module + std::string(text);
+  }
+}
+
+StackSampler::StackSampler(std::chrono::microseconds interval, int signal)
+  : interval_(interval),
+    signal_(signal == 0 ? SIGRTMIN + DEFAULT_SIGNAL_OFFSET : signal)
+{
+  if (signal_ <= 0 || signal_ >= NSIG || interval_.count() <= 0)
+  {
+    throw std::invalid_argument("StackSampler needs a valid signal and interval");
+  }
+  if (installed_.exchange(true, std::memory_order::acq_rel))
+  {
+    throw std::logic_error("Only one StackSampler may exist at a time");
+  }
+
+  struct sigaction sa_struct;
+  std::memset(&sa_struct, 0, sizeof(sa_struct));
+  sa_struct.sa_flags = SA_SIGINFO | SA_RESTART;
+  sa_struct.sa_sigaction = handler_callback;
+  sigemptyset(&sa_struct.sa_mask);
+
+  if (sigaction(signal_, &sa_struct, &old_action_) == -1)
+  {
+    int errc = errno;
+    installed_.store(false, std::memory_order::release);
+    throw std::system_error(errc, std::system_category());
+  }
+}
+
+StackSampler::~StackSampler()
+{
+  // Ignoring the signal discards the ones still pending, which the restored
+  // action (by default, termination) must not see
+  struct sigaction ignore;
+  std::memset(&ignore, 0, sizeof(ignore));
+  ignore.sa_handler = SIG_IGN;
+  sigaction(signal_, &ignore, nullptr);
+  sigaction(signal_, &old_action_, nullptr);
+
+  installed_.store(false, std::memory_order::release);
+}
+
+bool StackSampler::attach() noexcept
+{
+  if (current_)
+  {
+    return true;
+  }
+
+  ThreadBuffer_t* buffer = nullptr;
+  try
+  {
+    std::lock_guard lock(mtx_);
+    for (auto& candidate : buffers_)
+    {
+      if (!candidate->attached)
+      {
+        buffer = candidate.get();
+        break;
+      }
+    }
+    if (buffer == nullptr)
+    {
+      buffer = buffers_.emplace_back(std::make_unique<ThreadBuffer_t>()).get();
+    }
+    buffer->attached = true;
+  }
+  catch (...)
+  {
+    return false;
+  }
+
+  buffer->stack_lo = buffer->stack_hi = 0;
+  pthread_attr_t attr;
+  if (pthread_getattr_np(pthread_self(), &attr) == 0)
+  {
+    void* addr = nullptr;
+    size_t size = 0;
+    if (pthread_attr_getstack(&attr, &addr, &size) == 0)
+    {
+      buffer->stack_lo = reinterpret_cast<uintptr_t>(addr);
+      buffer->stack_hi = buffer->stack_lo + size;
+    }
+    pthread_attr_destroy(&attr);
+  }
+
+  sigevent event;
+  std::memset(&event, 0, sizeof(event));
+  event.sigev_notify = SIGEV_THREAD_ID;
+  event.sigev_signo = signal_;
+  event.sigev_notify_thread_id = gettid();
+
+  if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &buffer->timer) == -1)
+  {
+    std::lock_guard lock(mtx_);
+    buffer->attached = false;
+    return false;
+  }
+
+  // Threads may inherit a mask blocking RT signals
+  sigset_t unblock;
+  sigemptyset(&unblock);
+  sigaddset(&unblock, signal_);
+  pthread_sigmask(SIG_UNBLOCK, &unblock, nullptr);
+
+  current_ = buffer;
+
+  auto seconds = std::chrono::duration_cast<std::chrono::seconds>(interval_);
+  itimerspec spec;
+  spec.it_interval.tv_sec = static_cast<time_t>(seconds.count());
+  spec.it_interval.tv_nsec = static_cast<long>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(interval_ - seconds).count()
+  );
+  spec.it_value = spec.it_interval;
+  timer_settime(buffer->timer, 0, &spec, nullptr);
+  return true;
+}
+
+void StackSampler::detach() noexcept
+{
+  ThreadBuffer_t* buffer = current_;
+  if (buffer == nullptr)
+  {
+    return;
+  }
+
+  timer_delete(buffer->timer);
+  // A signal still pending finds nothing to record
+  current_ = nullptr;
+
+  std::lock_guard lock(mtx_);
+  buffer->attached = false;
+}
+
+void StackSampler::collect()
+{
+  std::lock_guard lock(mtx_);
+  for (auto& buffer : buffers_)
+  {
+    uint64_t head = buffer->head.load(std::memory_order::acquire);
+    uint64_t tail = buffer->tail.load(std::memory_order::relaxed);
+    for (; tail != head; tail++)
+    {
+      const Sample_t& sample = buffer->ring[tail % RING_SIZE];
+      if (sample.depth != 0)
+      {
+        stacks_[std::vector<uintptr_t>(sample.pcs, sample.pcs + sample.depth)]++;
+      }
+    }
+    // Hands the slots back to the handler
+    buffer->tail.store(tail, std::memory_order::release);
+  }
+}
+
+void StackSampler::write_folded(std::ostream& out)
+{
+  collect();
+
+  std::lock_guard lock(mtx_);
+  std::map<uintptr_t, std::string> names;
+  // Stacks differing only in addresses within the same functions merge
+  std::map<std::string, uint64_t> folded;
+  for (const auto& [pcs, count] : stacks_)
+  {
+    std::string line;
+    for (size_t i = pcs.size(); i-- > 0;)
+    {
+      // Return addresses point past the call, into the next line or symbol
+      uintptr_t pc = (i == 0) ? pcs[i] : pcs[i] - 1;
+      auto it = names.find(pc);
+      if (it == names.end())
+      {
+        it = names.emplace(pc, symbolize(pc)).first;
+      }
+      line += it->second;
+      if (i != 0)
+      {
+        line += ';';
+      }
+    }
+    folded[line] += count;
+  }
+
+  for (const auto& [line, count] : folded)
+  {
+    out << line << ' ' << count << '\n';
+  }
+}
+
+uint64_t StackSampler::samples()
+{
+  std::lock_guard lock(mtx_);
+  uint64_t total = 0;
+  for (auto& buffer : buffers_)
+  {
+    total += buffer->head.load(std::memory_order::relaxed);
+  }
+  return total;
+}
+
+uint64_t StackSampler::dropped()
+{
+  std::lock_guard lock(mtx_);
+  uint64_t total = 0;
+  for (auto& buffer : buffers_)
+  {
+    total += buffer->dropped.load(std::memory_order::relaxed);
+  }
+  return total;
+}
+
+void StackSampler::ThreadBuffer_t::record(void* context) noexcept
+{
+  uint64_t slot = head.load(std::memory_order::relaxed);
+  if (slot - tail.load(std::memory_order::acquire) == RING_SIZE)
+  {
+    dropped.fetch_add(1, std::memory_order::relaxed);
+    return;
+  }
+
+  uintptr_t pc = 0;
+  uintptr_t fp = 0;
+  auto* ucontext = static_cast<ucontext_t*>(context);
+#if defined(__x86_64__)
+  pc = static_cast<uintptr_t>(ucontext->uc_mcontext.gregs[REG_RIP]);
+  fp = static_cast<uintptr_t>(ucontext->uc_mcontext.gregs[REG_RBP]);
+#elif defined(__aarch64__)
+  pc = static_cast<uintptr_t>(ucontext->uc_mcontext.pc);
+  fp = static_cast<uintptr_t>(ucontext->uc_mcontext.regs[29]);
+#else
+  // Starts from the handler itself where the context layout is unknown
+  (void)ucontext;
+  fp = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+#endif
+
+  Sample_t& sample = ring[slot % RING_SIZE];
+  uint32_t depth = 0;
+  if (pc != 0)
+  {
+    sample.pcs[depth++] = pc;
+  }
+
+  // Each frame holds the caller's frame pointer, then the return address.
+  // Frames must stay on this thread's stack and grow towards its base
+  while (depth < MAX_DEPTH &&
+         fp >= stack_lo && fp + 2 * sizeof(uintptr_t) <= stack_hi &&
+         fp % alignof(uintptr_t) == 0)
+  {
+    const uintptr_t* frame = reinterpret_cast<const uintptr_t*>(fp);
+    uintptr_t next = frame[0];
+    uintptr_t ret = frame[1];
+    if (ret == 0)
+    {
+      break;
+    }
+    sample.pcs[depth++] = ret;
+    if (next <= fp)
+    {
+      break;
+    }
+    fp = next;
+  }
+  sample.depth = depth;
+
+  head.store(slot + 1, std::memory_order::release);
+}
+
+void StackSampler::handler_callback(int, siginfo_t*, void* context) noexcept
+{
+  int saved_errno = errno;
+  if (ThreadBuffer_t* buffer = current_)
+  {
+    buffer->record(context);
+  }
+  errno = saved_errno;
+}
@@ -0,0 +1,37 @@
+/**
+ * Helpers shared by the unit tests
+ */
+
+#pragma once
+
+
+#include <chrono>
+#include <thread>
+
+
+/**
+ * Polls `condition` until it holds or `limit` passes
+ *
+ * @param condition Callable returning whether the awaited state is reached
+ * @param limit Longest time to poll for
+ * @returns Whether `condition` held before the limit passed
+ */
+template <typename Condition>
+bool eventually(
+  Condition condition,
+  std::chrono::milliseconds limit = std::chrono::seconds(5)
+)
+{
+  // Returns on the first success, since `condition` may consume what it
+  // observes
+  auto deadline = std::chrono::steady_clock::now() + limit;
+  while (std::chrono::steady_clock::now() < deadline)
+  {
+    if (condition())
+    {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return condition();
+}
@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+#include <AdaptiveWait.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+TEST_CASE("AdaptiveWaiter: Wakes parked and spinning waiters", "[unit] [AdaptiveWait]")
+{
+  AdaptiveWaiter waiter;
+  std::atomic<bool> ready{false};
+
+  std::thread sleeper([&] {
+    waiter.wait([&] { return ready.load(std::memory_order::acquire); });
+  });
+  // Long enough for the waiter to park
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ready.store(true, std::memory_order::release);
+  waiter.notify_all();
+  sleeper.join();
+
+  // Satisfied waits return at once, without touching the budget
+  auto budget = waiter.spin_budget();
+  waiter.wait([] { return true; });
+  REQUIRE( waiter.spin_budget() == budget );
+}
+
+TEST_CASE("AdaptiveWaiter: Times out", "[unit] [AdaptiveWait]")
+{
+  AdaptiveWaiter waiter;
+  auto start = std::chrono::steady_clock::now();
+  REQUIRE_FALSE( waiter.wait_until([] { return false; }, start + std::chrono::milliseconds(10)) );
+  REQUIRE      ( std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(10) );
+}
+
+TEST_CASE("AdaptiveWaiter: Budget follows wake latency", "[unit] [AdaptiveWait]")
+{
+  static constexpr int ROUNDS = 16;
+  AdaptiveWaiter waiter;
+  std::atomic<int> turn{0};
+
+  // Waits ending long after parking shrink the budget towards its minimum.
+  // A waiter descheduled until just before its wake-up sees a short wait, so
+  // a loaded machine gets a few more attempts
+  for (int attempt = 0; attempt < 3; attempt++)
+  {
+    turn = 0;
+    std::thread slow([&] {
+      for (int i = 1; i <= ROUNDS; i++)
+      {
+        waiter.wait([&] { return turn.load(std::memory_order::acquire) >= i; });
+      }
+    });
+    for (int i = 1; i <= ROUNDS; i++)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      turn.store(i, std::memory_order::release);
+      waiter.notify_one();
+    }
+    slow.join();
+    if (waiter.spin_budget().count() < 2 * AdaptiveWaiter::MIN_SPIN_NS)
+    {
+      break;
+    }
+  }
+  REQUIRE( waiter.spin_budget().count() < 2 * AdaptiveWaiter::MIN_SPIN_NS );
+
+  // Immediate wake-ups caught while spinning keep it small, never above the cap
+  std::atomic<bool> flag{false};
+  std::thread quick([&] {
+    flag.store(true, std::memory_order::release);
+    waiter.notify_one();
+  });
+  waiter.wait([&] { return flag.load(std::memory_order::acquire); });
+  quick.join();
+  REQUIRE( waiter.spin_budget().count() <= AdaptiveWaiter::MAX_SPIN_NS );
+}
@@ -0,0 +1,175 @@
+#include <catch2/catch_test_macros.hpp>
+#include <Cancellation.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  // Counts its run and destroys its sibling
+  struct DropSibling
+  {
+    void operator()() const noexcept
+    {
+      fired->fetch_add(1);
+      sibling->reset();
+    }
+
+    std::atomic<int>* fired;
+    std::unique_ptr<CancellationCallback<DropSibling>>* sibling;
+  };
+
+  // Stops another source, then destroys its own registration
+  struct StopThenDropSelf
+  {
+    void operator()() const noexcept
+    {
+      other->request_stop();
+      self->reset();
+    }
+
+    CancellationSource* other;
+    std::unique_ptr<CancellationCallback<StopThenDropSelf>>* self;
+  };
+}
+
+TEST_CASE("Cancellation: Tokens and callbacks", "[unit] [Cancellation]")
+{
+  CancellationSource source;
+  CancellationToken token = source.get_token();
+  CancellationToken detached;
+
+  REQUIRE      ( token.stop_possible() );
+  REQUIRE_FALSE( detached.stop_possible() );
+  REQUIRE_FALSE( token.stop_requested() );
+
+  int fired = 0;
+  CancellationCallback kept(token, [&fired] () noexcept { fired += 1; });
+  {
+    CancellationCallback removed(token, [&fired] () noexcept { fired += 100; });
+  }
+
+  REQUIRE      ( source.request_stop() );
+  REQUIRE_FALSE( source.request_stop() );
+  REQUIRE      ( token.stop_requested() );
+  REQUIRE      ( fired == 1 );
+
+  // Registering after the stop runs the callback immediately
+  CancellationCallback late(token, [&fired] () noexcept { fired += 10; });
+  REQUIRE      ( fired == 11 );
+}
+
+TEST_CASE("Cancellation: Resetting re-arms a stopped source", "[unit] [Cancellation]")
+{
+  CancellationSource source;
+  int fired = 0;
+  {
+    CancellationCallback callback(source.get_token(), [&fired] () noexcept { fired += 1; });
+    REQUIRE      ( source.request_stop() );
+  }
+
+  source.reset();
+  REQUIRE_FALSE( source.stop_requested() );
+  REQUIRE_FALSE( source.get_token().stop_requested() );
+
+  // Callbacks register and run as on a fresh source
+  CancellationCallback callback(source.get_token(), [&fired] () noexcept { fired += 10; });
+  REQUIRE      ( fired == 1 );
+  REQUIRE      ( source.request_stop() );
+  REQUIRE      ( fired == 11 );
+}
+
+TEST_CASE("Cancellation: Concurrent registration and parallel dispatch", "[unit] [Cancellation]")
+{
+  constexpr unsigned THREADS = 4U;
+  constexpr unsigned PER_THREAD = 1000U;
+
+  CancellationSource source;
+  std::atomic<unsigned> fired{0};
+  auto bump = [&fired] () noexcept { fired.fetch_add(1, std::memory_order::relaxed); };
+  using Callback_t = CancellationCallback<decltype(bump)>;
+
+  std::vector<std::unique_ptr<Callback_t>> callbacks[THREADS];
+  {
+    std::vector<std::jthread> registrars;
+    for (unsigned t = 0; t < THREADS; t++)
+    {
+      registrars.emplace_back([&, t] {
+        for (unsigned i = 0; i < PER_THREAD; i++)
+        {
+          callbacks[t].push_back(std::make_unique<Callback_t>(source.get_token(), bump));
+          // Drop every other registration again to exercise removal
+          if (i % 2)
+          {
+            callbacks[t].pop_back();
+          }
+        }
+      });
+    }
+  }
+
+  REQUIRE( source.request_stop(THREADS) );
+  REQUIRE( fired.load() == THREADS * PER_THREAD / 2 );
+}
+
+TEST_CASE("Cancellation: Removal waits for a running callback", "[unit] [Cancellation]")
+{
+  CancellationSource source;
+  std::atomic<bool> started{false};
+  std::atomic<bool> finished{false};
+  auto slow = [&] () noexcept {
+    started.store(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    finished.store(true);
+  };
+
+  auto callback = std::make_unique<CancellationCallback<decltype(slow)>>(source.get_token(), slow);
+  std::jthread dispatcher([&source] { source.request_stop(); });
+  while (!started.load())
+  {
+    std::this_thread::yield();
+  }
+
+  callback.reset();
+  REQUIRE( finished.load() );
+}
+
+TEST_CASE("Cancellation: A callback may destroy a sibling that has not run", "[unit] [Cancellation]")
+{
+  CancellationSource source;
+  std::atomic<int> fired{0};
+  std::unique_ptr<CancellationCallback<DropSibling>> first;
+  std::unique_ptr<CancellationCallback<DropSibling>> second;
+
+  first = std::make_unique<CancellationCallback<DropSibling>>(
+    source.get_token(), DropSibling{&fired, &second}
+  );
+  second = std::make_unique<CancellationCallback<DropSibling>>(
+    source.get_token(), DropSibling{&fired, &first}
+  );
+
+  // Whichever runs first removes the other before it starts
+  REQUIRE( source.request_stop() );
+  REQUIRE( fired.load() == 1 );
+  REQUIRE( (first == nullptr) != (second == nullptr) );
+}
+
+TEST_CASE("Cancellation: A callback may stop another source, then destroy itself", "[unit] [Cancellation]")
+{
+  CancellationSource outer;
+  CancellationSource inner;
+  std::atomic<int> fired{0};
+  CancellationCallback counted(inner.get_token(), [&fired] () noexcept { fired.fetch_add(1); });
+
+  std::unique_ptr<CancellationCallback<StopThenDropSelf>> callback;
+  callback = std::make_unique<CancellationCallback<StopThenDropSelf>>(
+    outer.get_token(), StopThenDropSelf{&inner, &callback}
+  );
+
+  // The nested dispatch must not hide the outer callback from removal
+  REQUIRE( outer.request_stop() );
+  REQUIRE( fired.load() == 1 );
+  REQUIRE( callback == nullptr );
+}
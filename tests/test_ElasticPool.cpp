@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ElasticPool.hpp>
+#include "TestHelpers.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+TEST_CASE("ElasticPool: Runs tasks and rejects them after shutdown", "[unit] [ElasticPool]")
+{
+  ThreadManager tm;
+  std::atomic<unsigned> done{0};
+  {
+    ElasticPool pool(tm, {.min_workers = 2, .max_workers = 2});
+    REQUIRE( pool.workers() == 2U );
+
+    for (int i = 0; i < 100; i++)
+    {
+      pool.submit([&done] { done.fetch_add(1); });
+    }
+    pool.shutdown();
+
+    REQUIRE( done.load() == 100U );
+    REQUIRE( pool.workers() == 0 );
+    REQUIRE_THROWS( pool.submit([] { }) );
+  }
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE_THROWS( ElasticPool(tm, {.min_workers = 3, .max_workers = 2}) );
+  REQUIRE_THROWS( ElasticPool(tm, {.min_workers = 0, .max_workers = 2}) );
+}
+
+TEST_CASE("ElasticPool: Idle workers wake for every submission", "[unit] [ElasticPool]")
+{
+  ThreadManager tm;
+  std::atomic<unsigned> done{0};
+  {
+    ElasticPool pool(tm, {.min_workers = 2, .max_workers = 2});
+    for (unsigned i = 1; i <= 20; i++)
+    {
+      // Every task finds both workers idle, spinning or parked
+      REQUIRE( eventually([&pool] { return pool.idle_workers() == 2U; }) );
+      pool.submit([&done] { done.fetch_add(1); });
+      REQUIRE( eventually([&done, i] { return done.load() == i; }) );
+      if (i % 5 == 0)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+    }
+    pool.shutdown();
+    REQUIRE( pool.workers() == 0 );
+  }
+  REQUIRE_NOTHROW( tm.join() );
+}
+
+TEST_CASE("ElasticPool: Runs over managers with other policies", "[unit] [ElasticPool]")
+{
+  BasicThreadManager<SlotArrayRegistry, SpinLock, AtomicCounter, CountingStats> tm;
+  std::atomic<unsigned> done{0};
+  {
+    BasicElasticPool pool(tm, {.min_workers = 1, .max_workers = 2});
+    for (int i = 0; i < 10; i++)
+    {
+      pool.submit([&done] { done.fetch_add(1); });
+    }
+  }
+  REQUIRE( done.load() == 10U );
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE( tm.stats().spawned >= 2U );
+}
+
+TEST_CASE("ElasticPool: Grows while workers block and shrinks when idle", "[unit] [ElasticPool]")
+{
+  // Releases the tasks before the pool drains, even if a check fails
+  struct Releaser_t
+  {
+    ~Releaser_t() { flag = true; }
+    std::atomic<bool>& flag;
+  };
+
+  std::atomic<bool> release{false};
+  ThreadManager tm;
+  ElasticPool pool(tm, {
+    .min_workers = 1,
+    .max_workers = 4,
+    .cpu_target = 4,
+    .tick = std::chrono::milliseconds(5),
+    .grow_ticks = 2,
+    .idle_timeout = std::chrono::milliseconds(100),
+    .probe_kernel_state = false
+  });
+
+  Releaser_t releaser{release};
+  for (int i = 0; i < 4; i++)
+  {
+    pool.submit([&release] {
+      ElasticPool::BlockingScope blocking;
+      while (!release.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  }
+
+  REQUIRE( eventually([&] { return pool.workers() == 4U; }, std::chrono::seconds(2)) );
+  REQUIRE( eventually([&] { return pool.blocked_workers() == 4U; }, std::chrono::seconds(2)) );
+  REQUIRE( pool.queued() == 0 );
+
+  release = true;
+  REQUIRE( eventually([&] { return pool.workers() == 1U; }, std::chrono::seconds(2)) );
+  REQUIRE( pool.blocked_workers() == 0 );
+}
+
+TEST_CASE("ElasticPool: Global stop ends the pool threads", "[unit] [ElasticPool]")
+{
+  ThreadManager tm;
+  ElasticPool pool(tm, {.min_workers = 2, .max_workers = 2});
+
+  tm.request_stop_all();
+  REQUIRE( eventually([&] { return pool.workers() == 0; }, std::chrono::seconds(2)) );
+  REQUIRE_NOTHROW( pool.shutdown() );
+  REQUIRE_NOTHROW( tm.join() );
+}
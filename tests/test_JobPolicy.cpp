@@ -0,0 +1,143 @@
+#include <catch2/catch_test_macros.hpp>
+#include <JobPolicy.hpp>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include <cerrno>
+
+#include <linux/ioprio.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+  // Runs `check` in a forked child after prepare_child(); returns its exit
+  // code, 100 + errno if the policy failed to apply (unless `always`)
+  template <typename Check>
+  int in_child(const JobPolicy& policy, Check check, bool always = false)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      int error = policy.prepare_child();
+      _exit(error != 0 && !always ? 100 + error : check());
+    }
+
+    int status = 0;
+    if (pid == -1 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+    {
+      return -1;
+    }
+    return WEXITSTATUS(status);
+  }
+
+  int oom_score_adj()
+  {
+    int value = 0;
+    std::ifstream("/proc/self/oom_score_adj") >> value;
+    return value;
+  }
+}
+
+TEST_CASE("JobPolicy: Applies the knobs in the child only", "[unit] [JobPolicy]")
+{
+  JobPolicyConfig_t config;
+  config.oom_score_adj = 500;
+  config.nice = 10;
+  config.cpu_policy = CPU_POLICY_ENM::batch;
+  config.io_class = IO_CLASS_ENM::best_effort;
+  config.io_level = 6;
+  JobPolicy policy(config);
+
+  int parent_oom = oom_score_adj();
+  int parent_policy = sched_getscheduler(0);
+
+  // Raising the OOM score and the nice value needs no privilege
+  REQUIRE( in_child(policy, [] {
+    errno = 0;
+    if (getpriority(PRIO_PROCESS, 0) != 10 || errno != 0)
+    {
+      return 1;
+    }
+    if (sched_getscheduler(0) != SCHED_BATCH)
+    {
+      return 2;
+    }
+    if (syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0) != IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 6))
+    {
+      return 3;
+    }
+    return oom_score_adj() == 500 ? 0 : 4;
+  }) == 0 );
+
+  REQUIRE( oom_score_adj() == parent_oom );
+  REQUIRE( sched_getscheduler(0) == parent_policy );
+
+  JobPolicyConfig_t idle;
+  idle.nice = 19;
+  idle.cpu_policy = CPU_POLICY_ENM::idle;
+  idle.io_class = IO_CLASS_ENM::idle;
+  REQUIRE( in_child(JobPolicy(idle), [] {
+    if (sched_getscheduler(0) != SCHED_IDLE)
+    {
+      return 1;
+    }
+    long ioprio = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+    return IOPRIO_PRIO_CLASS(ioprio) == IOPRIO_CLASS_IDLE ? 0 : 2;
+  }) == 0 );
+}
+
+TEST_CASE("JobPolicy: Children drop the supervisor's boost", "[unit] [JobPolicy]")
+{
+  bool prioritized = false;
+  int child = -1;
+  int failing_child = -1;
+  // A thread of its own, so the boost does not outlive the test
+  std::thread supervisor([&] {
+    prioritized = JobPolicy::prioritize_thread();
+    auto unboosted = [] {
+      errno = 0;
+      return getpriority(PRIO_PROCESS, 0) == 0 && errno == 0 ? 0 : 1;
+    };
+    child = in_child(JobPolicy(), unboosted);
+    // Lowering the OOM score fails without CAP_SYS_RESOURCE; the boost
+    // must be gone either way
+    JobPolicyConfig_t protected_job;
+    protected_job.oom_score_adj = -1000;
+    failing_child = in_child(JobPolicy(protected_job), unboosted, true);
+    if (prioritized)
+    {
+      errno = 0;
+      prioritized = getpriority(PRIO_PROCESS, static_cast<id_t>(gettid())) == JobPolicy::SUPERVISOR_NICE;
+    }
+  });
+  supervisor.join();
+  if (!prioritized)
+  {
+    WARN("No privilege to raise the supervisor's priority");
+  }
+  REQUIRE( child == 0 );
+  REQUIRE( failing_child == 0 );
+}
+
+TEST_CASE("JobPolicy: Rejects values out of range", "[unit] [JobPolicy]")
+{
+  JobPolicyConfig_t config;
+  config.oom_score_adj = 1001;
+  REQUIRE_THROWS_AS( JobPolicy(config), std::invalid_argument );
+
+  config = {};
+  config.nice = 20;
+  REQUIRE_THROWS_AS( JobPolicy(config), std::invalid_argument );
+
+  config = {};
+  config.io_level = 8;
+  REQUIRE_THROWS_AS( JobPolicy(config), std::invalid_argument );
+
+  REQUIRE_THROWS_AS( JobPolicy::prioritize_thread(-21), std::invalid_argument );
+  REQUIRE_NOTHROW( JobPolicy(JobPolicyConfig_t{-1000, -20, CPU_POLICY_ENM::normal, IO_CLASS_ENM::realtime, 0}) );
+}
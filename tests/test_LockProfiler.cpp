@@ -0,0 +1,58 @@
+#include <catch2/catch_test_macros.hpp>
+#include <LockProfiler.hpp>
+#include <ThreadManager.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+TEST_CASE("ProfiledLock: Counts acquisitions and times contention", "[unit] [LockProfiler]")
+{
+  ProfiledLock<std::mutex> mtx;
+  {
+    std::lock_guard lock(mtx);
+  }
+  REQUIRE( mtx.try_lock() );
+  std::atomic<bool> waiting{false};
+  std::thread contender([&] {
+    waiting = true;
+    std::lock_guard lock(mtx);
+  });
+  while (!waiting.load())
+  {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  mtx.unlock();
+  contender.join();
+
+  LockStats_t stats = mtx.stats();
+  REQUIRE( stats.acquisitions == 3U );
+  REQUIRE( stats.contended == 1U );
+  REQUIRE( stats.wait_ns > 0U );
+  REQUIRE( std::accumulate(stats.wait_histogram.begin(), stats.wait_histogram.end(),
+                           uint64_t{0}) == 1U );
+  REQUIRE( stats.holds == 0U );
+}
+
+TEST_CASE("ProfiledLock: Reports ThreadManager's registry lock", "[unit] [LockProfiler]")
+{
+  BasicThreadManager<HashRegistry, ProfiledLock<std::mutex>> tm;
+  for (int i = 0; i < 4; i++)
+  {
+    tm.spawn_thread([] (std::stop_token, std::stop_token) { });
+  }
+  tm.join();
+
+  ThreadManagerStats_t stats = tm.stats();
+  REQUIRE( stats.registry_lock.acquisitions == 5U );
+  REQUIRE( stats.registry_lock.holds == 1U );
+  REQUIRE( std::accumulate(stats.registry_lock.hold_histogram.begin(),
+                           stats.registry_lock.hold_histogram.end(),
+                           uint64_t{0}) == 1U );
+
+  BasicThreadManager<HashRegistry, std::mutex> plain;
+  plain.join();
+  REQUIRE( plain.stats().registry_lock.acquisitions == 0U );
+}
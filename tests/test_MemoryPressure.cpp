@@ -0,0 +1,203 @@
+#include <catch2/catch_test_macros.hpp>
+#include <MemoryPressure.hpp>
+#include <chrono>
+#include <optional>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <csignal>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+  // Forks a child that sleeps until killed
+  pid_t spawn_sleeper()
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      for (;;)
+      {
+        pause();
+      }
+    }
+    return pid;
+  }
+
+  // Waits for `pid` to report a stop (true) or a continue (false)
+  bool reported_stop(pid_t pid)
+  {
+    int status = 0;
+    if (waitpid(pid, &status, WUNTRACED | WCONTINUED) != pid)
+    {
+      return false;
+    }
+    return WIFSTOPPED(status);
+  }
+
+  void reap(pid_t pid)
+  {
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+  }
+}
+
+TEST_CASE("MemoryPressure: Throttles, suspends the newest jobs and resumes them", "[unit] [MemoryPressure]")
+{
+  ThreadManager tm;
+  std::vector<pid_t> jobs;
+  for (int i = 0; i < 3; i++)
+  {
+    pid_t pid = spawn_sleeper();
+    REQUIRE( pid > 0 );
+    jobs.push_back(pid);
+  }
+
+  {
+    MemoryPressureConfig_t config;
+    // Keeps the monitor from stepping down while the test drives the levels
+    config.settle = std::chrono::minutes(10);
+    std::optional<MemoryPressure> pressure;
+    try
+    {
+      pressure.emplace(tm, config);
+    }
+    catch (const std::system_error& e)
+    {
+      WARN("PSI triggers unavailable: " << e.what());
+      for (pid_t pid : jobs)
+      {
+        reap(pid);
+      }
+      return;
+    }
+
+    for (pid_t pid : jobs)
+    {
+      pressure->track(pid);
+    }
+    REQUIRE( pressure->admitted() );
+
+    pressure->apply(PRESSURE_LEVEL_ENM::throttle);
+    REQUIRE_FALSE( pressure->admitted() );
+    REQUIRE( pressure->suspended() == 0 );
+
+    // One job per event, newest first
+    pressure->apply(PRESSURE_LEVEL_ENM::suspend);
+    REQUIRE( pressure->level() == PRESSURE_LEVEL_ENM::suspend );
+    REQUIRE( pressure->suspended() == 1 );
+    REQUIRE( reported_stop(jobs[2]) );
+    pressure->apply(PRESSURE_LEVEL_ENM::suspend);
+    REQUIRE( pressure->suspended() == 2 );
+    REQUIRE( reported_stop(jobs[1]) );
+
+    // A launcher blocked on admission resumes once pressure clears
+    std::stop_source source;
+    bool waited = false;
+    std::thread launcher([&] { waited = pressure->wait_admitted(source.get_token()); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pressure->apply(PRESSURE_LEVEL_ENM::normal);
+    launcher.join();
+    REQUIRE( waited );
+    REQUIRE( pressure->suspended() == 0 );
+    REQUIRE_FALSE( reported_stop(jobs[2]) );
+    REQUIRE_FALSE( reported_stop(jobs[1]) );
+
+    // Shutdown resumes what is still stopped
+    pressure->apply(PRESSURE_LEVEL_ENM::suspend);
+    REQUIRE( reported_stop(jobs[2]) );
+    pressure->untrack(jobs[0]);
+    pressure->shutdown();
+    REQUIRE( pressure->admitted() );
+    REQUIRE( pressure->suspended() == 0 );
+    REQUIRE_FALSE( reported_stop(jobs[2]) );
+  }
+
+  for (pid_t pid : jobs)
+  {
+    reap(pid);
+  }
+}
+
+TEST_CASE("MemoryPressure: A stop request ends waiting for admission", "[unit] [MemoryPressure]")
+{
+  ThreadManager tm;
+  std::optional<MemoryPressure> pressure;
+  try
+  {
+    pressure.emplace(tm);
+  }
+  catch (const std::system_error& e)
+  {
+    WARN("PSI triggers unavailable: " << e.what());
+    return;
+  }
+
+  pressure->apply(PRESSURE_LEVEL_ENM::throttle);
+  std::stop_source source;
+  bool waited = true;
+  std::thread launcher([&] { waited = pressure->wait_admitted(source.get_token()); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  source.request_stop();
+  launcher.join();
+  REQUIRE_FALSE( waited );
+
+  // A global stop ends the monitor, which admits again
+  tm.request_stop_all();
+  REQUIRE( pressure->wait_admitted({}) );
+}
+
+TEST_CASE("MemoryPressure: Throws without PSI", "[unit] [MemoryPressure]")
+{
+  ThreadManager tm;
+  MemoryPressureConfig_t config;
+  config.path = "/proc/pressure/does-not-exist";
+  REQUIRE_THROWS_AS( MemoryPressure(tm, config), std::system_error );
+  REQUIRE( tm.total_threads() == 0 );
+}
+
+TEST_CASE("MemoryPressure: Runs over managers with other policies", "[unit] [MemoryPressure]")
+{
+  BasicThreadManager<SlotArrayRegistry, SpinLock, AtomicCounter, CountingStats> tm;
+  // The stop callback fires while constructing
+  tm.request_stop_all();
+  std::optional<MemoryPressure> pressure;
+  try
+  {
+    pressure.emplace(tm);
+  }
+  catch (const std::system_error& e)
+  {
+    WARN("PSI triggers unavailable: " << e.what());
+    return;
+  }
+
+  REQUIRE( pressure->wait_admitted({}) );
+  pressure.reset();
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE( tm.stats().spawned == 0 );
+}
+
+TEST_CASE("MemoryPressure: A join on the manager does not wait for the monitor", "[unit] [MemoryPressure]")
+{
+  ThreadManager tm;
+  std::optional<MemoryPressure> pressure;
+  try
+  {
+    pressure.emplace(tm);
+  }
+  catch (const std::system_error& e)
+  {
+    WARN("PSI triggers unavailable: " << e.what());
+    return;
+  }
+
+  tm.spawn_thread([](std::stop_token, std::stop_token){ });
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE( tm.total_threads() == 0 );
+  REQUIRE( pressure->admitted() );
+}
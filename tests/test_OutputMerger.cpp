@@ -0,0 +1,220 @@
+#include <catch2/catch_test_macros.hpp>
+#include <OutputMerger.hpp>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+  // Reads everything written to the temporary file so far
+  std::string read_back(int fd)
+  {
+    std::string out;
+    char buffer[4096];
+    lseek(fd, 0, SEEK_SET);
+    for (ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0;)
+    {
+      out.append(buffer, n);
+    }
+    return out;
+  }
+
+  int temp_fd()
+  {
+    char path[] = "/tmp/pl_output_merger_XXXXXX";
+    int fd = mkstemp(path);
+    unlink(path);
+    return fd;
+  }
+}
+
+TEST_CASE("OutputMerger: Tagged line buffering does not tear lines", "[unit] [OutputMerger]")
+{
+  int fd = temp_fd();
+  REQUIRE( fd != -1 );
+
+  {
+    OutputMerger merger(fd, {.tag = true, .line_buffer = true}, 1UL << 16,
+                        std::chrono::hours(1));
+    uint32_t a = merger.add_source("a");
+    uint32_t b = merger.add_source("b");
+
+    merger.write(a, "first ha");
+    merger.write(b, "one\ntw");
+    merger.write(a, "lf\nsecond");
+    merger.write(b, "o\n");
+    merger.close_source(a);
+    merger.close_source(b);
+    merger.flush();
+
+    REQUIRE( merger.syscalls() == 1U );
+    REQUIRE_THROWS( merger.write(a, "closed\n") );
+  }
+
+  REQUIRE( read_back(fd) == "b\tone\na\tfirst half\nb\ttwo\na\tsecond\n" );
+  close(fd);
+}
+
+TEST_CASE("OutputMerger: Grouped output and writev batching", "[unit] [OutputMerger]")
+{
+  constexpr unsigned LINES = 10000U;
+
+  int fd = temp_fd();
+  REQUIRE( fd != -1 );
+
+  std::ostringstream expected;
+  uint64_t syscalls = 0;
+  {
+    OutputMerger merger(fd, {}, 1UL << 16, std::chrono::hours(1));
+    uint32_t a = merger.add_source("a");
+    uint32_t b = merger.add_source("b");
+
+    for (unsigned i = 0; i < LINES; i++)
+    {
+      merger.write(a, "a" + std::to_string(i) + "\n");
+      merger.write(b, "b" + std::to_string(i) + "\n");
+      expected << "b" << i << "\n";
+    }
+    merger.close_source(b);
+    for (unsigned i = 0; i < LINES; i++)
+    {
+      expected << "a" << i << "\n";
+    }
+    merger.close_source(a);
+    merger.flush();
+    syscalls = merger.syscalls();
+  }
+
+  REQUIRE( read_back(fd) == expected.str() );
+  REQUIRE( syscalls < 2U * LINES / 100U );
+  close(fd);
+}
+
+TEST_CASE("OutputMerger: The last batch of a quiet source is flushed in time", "[unit] [OutputMerger]")
+{
+  int fd = temp_fd();
+  REQUIRE( fd != -1 );
+
+  {
+    OutputMerger merger(fd, {.tag = true, .line_buffer = true}, 1UL << 16,
+                        std::chrono::milliseconds(20));
+    uint32_t job = merger.add_source("job");
+    merger.write(job, "only line\n");
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (merger.syscalls() == 0 && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE( merger.syscalls() == 1U );
+    REQUIRE( read_back(fd) == "job\tonly line\n" );
+  }
+  close(fd);
+}
+
+TEST_CASE("OutputMerger: A failed writev keeps only the unwritten bytes", "[unit] [OutputMerger]")
+{
+  int fd = temp_fd();
+  REQUIRE( fd != -1 );
+
+  // The file size limit is process-wide, hence the child
+  pid_t pid = fork();
+  REQUIRE( pid != -1 );
+  if (pid == 0)
+  {
+    signal(SIGXFSZ, SIG_IGN);
+    rlimit limit{};
+    getrlimit(RLIMIT_FSIZE, &limit);
+    rlimit small = limit;
+    small.rlim_cur = 10;
+    setrlimit(RLIMIT_FSIZE, &small);
+
+    int code = 0;
+    {
+      OutputMerger merger(fd, {.tag = true, .line_buffer = false}, 1UL << 16,
+                          std::chrono::hours(1));
+      uint32_t job = merger.add_source("job");
+      merger.write(job, "0123456789ABCDEF\n");
+      try
+      {
+        // Writes 10 bytes, then fails with EFBIG
+        merger.close_source(job);
+        merger.flush();
+        code = 1;
+      }
+      catch (const std::system_error&)
+      { }
+
+      setrlimit(RLIMIT_FSIZE, &limit);
+      merger.flush();
+    }
+    if (code == 0 && read_back(fd) != "job\t0123456789ABCDEF\n")
+    {
+      code = 2;
+    }
+    _exit(code);
+  }
+
+  int status = 0;
+  REQUIRE( waitpid(pid, &status, 0) == pid );
+  REQUIRE( WIFEXITED(status) );
+  REQUIRE( WEXITSTATUS(status) == 0 );
+  close(fd);
+}
+
+TEST_CASE("OutputMerger: A write failing to flush neither loses nor repeats output", "[unit] [OutputMerger]")
+{
+  int fd = temp_fd();
+  REQUIRE( fd != -1 );
+
+  // The file size limit is process-wide, hence the child
+  pid_t pid = fork();
+  REQUIRE( pid != -1 );
+  if (pid == 0)
+  {
+    signal(SIGXFSZ, SIG_IGN);
+    rlimit limit{};
+    getrlimit(RLIMIT_FSIZE, &limit);
+    rlimit small = limit;
+    small.rlim_cur = 10;
+    setrlimit(RLIMIT_FSIZE, &small);
+
+    int code = 0;
+    {
+      OutputMerger merger(fd, {.tag = false, .line_buffer = true}, 4,
+                          std::chrono::hours(1));
+      uint32_t job = merger.add_source("job");
+      merger.write(job, "01234");
+      try
+      {
+        // Completes two lines, fills the batch and fails after 10 bytes
+        merger.write(job, "56789AB\nCD\nEF");
+        code = 1;
+      }
+      catch (const std::system_error&)
+      { }
+
+      setrlimit(RLIMIT_FSIZE, &limit);
+      merger.close_source(job);
+      merger.flush();
+    }
+    if (code == 0 && read_back(fd) != "0123456789AB\nCD\nEF\n")
+    {
+      code = 2;
+    }
+    _exit(code);
+  }
+
+  int status = 0;
+  REQUIRE( waitpid(pid, &status, 0) == pid );
+  REQUIRE( WIFEXITED(status) );
+  REQUIRE( WEXITSTATUS(status) == 0 );
+  close(fd);
+}
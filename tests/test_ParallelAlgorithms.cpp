@@ -0,0 +1,103 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ParallelAlgorithms.hpp>
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("ParallelAlgorithms: parallel_for covers every index exactly once", "[unit] [ParallelAlgorithms]")
+{
+  constexpr size_t SIZE = 100000UL;
+
+  ThreadManager tm;
+  std::vector<std::atomic<unsigned>> hits(SIZE);
+
+  REQUIRE( parallel_for(tm, size_t{0}, SIZE, [&hits](size_t i) {
+    hits[i].fetch_add(1, std::memory_order::relaxed);
+  }, {.grain = 64, .threads = 4}) );
+
+  REQUIRE( std::all_of(hits.begin(), hits.end(), [](const auto& h) { return h.load() == 1U; }) );
+
+  // Empty ranges trivially succeed
+  REQUIRE( parallel_for(tm, 5, 5, [](int, int) { FAIL("body called"); }) );
+  REQUIRE_NOTHROW( tm.join() );
+}
+
+TEST_CASE("ParallelAlgorithms: parallel_reduce and exceptions", "[unit] [ParallelAlgorithms]")
+{
+  ThreadManager tm;
+
+  auto sum = parallel_reduce(
+    tm, 0L, 1000001L, 0L,
+    [](long begin, long end, long acc) {
+      for (long i = begin; i < end; i++)
+      {
+        acc += i;
+      }
+      return acc;
+    },
+    [](long a, long b) { return a + b; },
+    {.threads = 4}
+  );
+  REQUIRE( sum.has_value() );
+  REQUIRE( *sum == 500000500000L );
+
+  REQUIRE_THROWS_AS(
+    parallel_for(tm, 0, 1000, [](int i) {
+      if (i == 500)
+      {
+        throw std::runtime_error("boom");
+      }
+    }, {.grain = 10, .threads = 4}),
+    std::runtime_error
+  );
+  REQUIRE_NOTHROW( tm.join() );
+}
+
+TEST_CASE("ParallelAlgorithms: parallel_sort and cancellation", "[unit] [ParallelAlgorithms]")
+{
+  ThreadManager tm;
+
+  std::vector<int> values(200000);
+  std::mt19937 rng(42);
+  std::generate(values.begin(), values.end(), rng);
+  std::vector<int> expected = values;
+  std::sort(expected.begin(), expected.end());
+
+  REQUIRE( parallel_sort(tm, values.begin(), values.end(), std::less<>{}, {.grain = 1000, .threads = 4}) );
+  REQUIRE( values == expected );
+
+  std::atomic<bool> stopped_once{false};
+  bool completed = parallel_for(tm, 0, 100000, [&](int i) {
+    if (i == 10 && !stopped_once.exchange(true))
+    {
+      tm.request_stop_all();
+    }
+  }, {.grain = 1, .threads = 2});
+  REQUIRE_FALSE( completed );
+  REQUIRE_FALSE( parallel_sort(tm, values.begin(), values.end()) );
+  REQUIRE_FALSE( parallel_reduce(tm, 0, 10, 0, [](int, int, int a) { return a; }, [](int a, int) { return a; }).has_value() );
+  REQUIRE_NOTHROW( tm.join() );
+}
+
+TEST_CASE("ParallelAlgorithms: Run over managers with other policies", "[unit] [ParallelAlgorithms]")
+{
+  BasicThreadManager<SlotArrayRegistry, SpinLock, AtomicCounter, CountingStats> tm;
+
+  std::vector<int> values(50000);
+  std::iota(values.rbegin(), values.rend(), 0);
+  REQUIRE( parallel_sort(tm, values.begin(), values.end(), std::less<>{}, {.grain = 1000, .threads = 4}) );
+  REQUIRE( std::is_sorted(values.begin(), values.end()) );
+
+  auto count = parallel_reduce(
+    tm, 0, 1000, 0,
+    [](int begin, int end, int acc) { return acc + (end - begin); },
+    [](int a, int b) { return a + b; },
+    {.grain = 10, .threads = 4}
+  );
+  REQUIRE( count == 1000 );
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE( tm.stats().spawned > 0U );
+}
@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+#include <PerCpuCounter.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE("PerCpuCounter: Slot count and single threaded totals", "[unit] [PerCpuCounter]")
+{
+  PerCpuCounter counter(3);
+  REQUIRE( counter.slots() == 4U );
+  REQUIRE( counter.load() == 0 );
+
+  counter.add(5);
+  counter.sub(2);
+  REQUIRE( counter.load() == 3 );
+
+  PerCpuCounter defaulted;
+  REQUIRE( defaulted.slots() >= 1U );
+}
+
+TEST_CASE("PerCpuCounter: Exact totals under concurrent updates", "[unit] [PerCpuCounter]")
+{
+  constexpr unsigned THREADS = 8U;
+  constexpr unsigned OPS = 100000U;
+
+  PerCpuCounter counter;
+  {
+    std::vector<std::jthread> threads;
+    for (unsigned t = 0; t < THREADS; t++)
+    {
+      threads.emplace_back([&counter] {
+        for (unsigned i = 0; i < OPS; i++)
+        {
+          counter.add(2);
+          counter.sub(1);
+        }
+      });
+    }
+  }
+
+  REQUIRE( counter.load() == static_cast<int64_t>(THREADS) * OPS );
+}
+
+TEST_CASE("PerCpuCounter: Loads stay within bounds while updates are in flight", "[unit] [PerCpuCounter]")
+{
+  constexpr unsigned THREADS = 8U;
+  constexpr unsigned OPS = 100000U;
+
+  PerCpuCounter counter;
+  std::atomic<bool> out_of_bounds{false};
+  {
+    std::vector<std::jthread> threads;
+    for (unsigned t = 0; t < THREADS; t++)
+    {
+      threads.emplace_back([&counter] {
+        for (unsigned i = 0; i < OPS; i++)
+        {
+          counter.add(1);
+          // Lets the thread migrate between its two updates now and then
+          if (i % 64 == 0)
+          {
+            std::this_thread::yield();
+          }
+          counter.sub(1);
+        }
+      });
+    }
+
+    // The true total is always within [0, THREADS]
+    for (unsigned i = 0; i < OPS; i++)
+    {
+      int64_t total = counter.load();
+      if (total < 0 || total > static_cast<int64_t>(THREADS))
+      {
+        out_of_bounds.store(true);
+      }
+    }
+  }
+
+  REQUIRE_FALSE( out_of_bounds.load() );
+  REQUIRE( counter.load() == 0 );
+}
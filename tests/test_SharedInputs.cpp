@@ -0,0 +1,85 @@
+#include <catch2/catch_test_macros.hpp>
+#include <SharedInputs.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+TEST_CASE("SharedInputs: Loading a file into a sealed memfd", "[unit] [SharedInputs]")
+{
+  char path[] = "/tmp/pl_shared_input_XXXXXX";
+  int tmpfd = mkstemp(path);
+  REQUIRE( tmpfd != -1 );
+  close(tmpfd);
+
+  const std::string contents(100000, 'x');
+  std::ofstream(path) << contents;
+
+  SharedInputs inputs;
+  int memfd = inputs.add("reference", path);
+  std::remove(path);
+
+  REQUIRE      ( memfd >= 0 );
+  REQUIRE      ( inputs.count() == 1U );
+  REQUIRE      ( inputs.fd("reference") == memfd );
+  REQUIRE      ( inputs.size("reference") == contents.size() );
+  REQUIRE      ( inputs.proc_path("reference") == "/proc/self/fd/" + std::to_string(memfd) );
+
+  int seals = fcntl(memfd, F_GET_SEALS);
+  REQUIRE      ( (seals & F_SEAL_WRITE) );
+  REQUIRE      ( (seals & F_SEAL_SEAL) );
+  REQUIRE      ( pwrite(memfd, "y", 1, 0) == -1 );
+  REQUIRE      ( (fcntl(memfd, F_GETFD) & FD_CLOEXEC) );
+
+  void* map = mmap(nullptr, contents.size(), PROT_READ, MAP_SHARED, memfd, 0);
+  REQUIRE      ( map != MAP_FAILED );
+  REQUIRE      ( std::memcmp(map, contents.data(), contents.size()) == 0 );
+  munmap(map, contents.size());
+
+  REQUIRE_THROWS( inputs.add("reference", "/dev/null") );
+  REQUIRE_THROWS( inputs.add("missing", "/nonexistent/input") );
+  REQUIRE_THROWS( inputs.fd("missing") );
+}
+
+TEST_CASE("SharedInputs: Buffers, environment and inheritance by children", "[unit] [SharedInputs]")
+{
+  SharedInputs inputs;
+  const char data[] = "shared bytes";
+  int memfd = inputs.add_buffer("small.txt", data, sizeof(data));
+
+  auto env = inputs.environment();
+  REQUIRE( env.size() == 1U );
+  REQUIRE( env[0] == "PL_SHARED_SMALL_TXT=/proc/self/fd/" + std::to_string(memfd) );
+
+  pid_t pid = fork();
+  REQUIRE( pid != -1 );
+  if (pid == 0)
+  {
+    inputs.prepare_child();
+    bool inheritable = !(fcntl(memfd, F_GETFD) & FD_CLOEXEC);
+    _exit(inheritable ? 0 : 1);
+  }
+
+  int status = 0;
+  REQUIRE( waitpid(pid, &status, 0) == pid );
+  REQUIRE( WIFEXITED(status) );
+  REQUIRE( WEXITSTATUS(status) == 0 );
+  REQUIRE( (fcntl(memfd, F_GETFD) & FD_CLOEXEC) );
+}
+
+TEST_CASE("SharedInputs: Names mapping to the same variable are rejected", "[unit] [SharedInputs]")
+{
+  SharedInputs inputs;
+  const char data[] = "x";
+  inputs.add_buffer("a-b", data, sizeof(data));
+  REQUIRE( inputs.environment().size() == 1U );
+
+  REQUIRE_THROWS_AS( inputs.add_buffer("a_b", data, sizeof(data)), std::invalid_argument );
+  REQUIRE( inputs.count() == 1U );
+  REQUIRE( inputs.environment().size() == 1U );
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch_test_macros.hpp>
+#include <SignalExecutor.hpp>
+#include "TestHelpers.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <thread>
+
+TEST_CASE("SignalExecutor: Runs callbacks on the pool", "[unit] [SignalExecutor]")
+{
+  ThreadManager tm;
+  ElasticPool pool(tm, {.min_workers = 1, .max_workers = 2});
+  std::atomic<int> received{0};
+  std::atomic<bool> on_pool{false};
+  const std::thread::id caller = std::this_thread::get_id();
+
+  {
+    SignalExecutor executor(tm, pool, {SIGUSR1});
+    REQUIRE_THROWS_AS( executor.on(SIGUSR2, [] (int) { }), std::invalid_argument );
+
+    executor.on(SIGUSR1, [&] (int sig) {
+      on_pool = std::this_thread::get_id() != caller;
+      received = sig;
+    });
+    kill(getpid(), SIGUSR1);
+
+    REQUIRE( eventually([&] { return received.load() == SIGUSR1; },
+                        std::chrono::seconds(5)) );
+    REQUIRE( on_pool.load() );
+  }
+
+  pool.shutdown();
+  REQUIRE_NOTHROW( tm.join() );
+}
+
+TEST_CASE("SignalExecutor: Coalesces signals arriving meanwhile", "[unit] [SignalExecutor]")
+{
+  ThreadManager tm;
+  ElasticPool pool(tm, {.min_workers = 2, .max_workers = 2});
+  std::atomic<int> runs{0};
+  std::atomic<bool> release{false};
+
+  {
+    SignalExecutor executor(tm, pool, {SIGUSR1});
+    executor.on(SIGUSR1, [&] (int) {
+      runs.fetch_add(1);
+      while (!release.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+
+    kill(getpid(), SIGUSR1);
+    REQUIRE( eventually([&] { return runs.load() == 1; }, std::chrono::seconds(5)) );
+
+    // Each lands in its own wakeup of the waiter, then merges into one rerun
+    for (int i = 0; i < 3; i++)
+    {
+      kill(getpid(), SIGUSR1);
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    release = true;
+
+    REQUIRE( eventually([&] { return runs.load() == 2; }, std::chrono::seconds(5)) );
+    executor.shutdown();
+    REQUIRE( runs.load() == 2 );
+    REQUIRE( executor.coalesced() >= 1U );
+  }
+
+  pool.shutdown();
+  REQUIRE_NOTHROW( tm.join() );
+}
+
+TEST_CASE("SignalExecutor: Runs over other manager policies", "[unit] [SignalExecutor]")
+{
+  BasicThreadManager<SlotArrayRegistry, SpinLock, AtomicCounter, CountingStats> tm;
+  BasicElasticPool pool(tm, {.min_workers = 1, .max_workers = 1});
+  std::atomic<int> received{0};
+
+  {
+    BasicSignalExecutor executor(tm, pool, {SIGUSR1});
+    executor.on(SIGUSR1, [&] (int sig) { received = sig; });
+    kill(getpid(), SIGUSR1);
+
+    REQUIRE( eventually([&] { return received.load() == SIGUSR1; },
+                        std::chrono::seconds(5)) );
+  }
+
+  pool.shutdown();
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE( tm.stats().spawned >= 3U );
+}
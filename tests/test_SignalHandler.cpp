@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+#include <SignalHandler.hpp>
+#include "TestHelpers.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <signal.h>
+#include <unistd.h>
+
+TEST_CASE("StaticSignalHandler: Compile time masks", "[unit] [SignalHandler]")
+{
+  using Handler = StaticSignalHandler<SIGUSR1, SIGUSR2, 40>;
+
+  STATIC_REQUIRE( Handler::MASK.OS_sigs == (signal_bitmask(SIGUSR1) | signal_bitmask(SIGUSR2)) );
+  STATIC_REQUIRE( Handler::MASK.RT_sigs == signal_bitmask(40) );
+  STATIC_REQUIRE( Handler::MASK.reserved == 0U );
+  STATIC_REQUIRE( Handler::handles(SIGUSR2) );
+  STATIC_REQUIRE_FALSE( Handler::handles(SIGINT) );
+}
+
+TEST_CASE("StaticSignalHandler: Raising, testing and popping signals", "[unit] [SignalHandler]")
+{
+  StaticSignalHandler<SIGUSR1, SIGUSR2> handler;
+
+  REQUIRE_FALSE( handler.test_signal<SIGUSR1>() );
+  REQUIRE      ( kill(getpid(), SIGUSR1) == 0 );
+  REQUIRE      ( eventually([&] { return handler.test_signal<SIGUSR1>(); }, std::chrono::seconds(2)) );
+  REQUIRE      ( handler.test_signal(SIGUSR1) );
+  REQUIRE_FALSE( handler.test_signal<SIGUSR2>() );
+
+  REQUIRE      ( handler.pop_signal<SIGUSR1>() );
+  REQUIRE_FALSE( handler.test_signal<SIGUSR1>() );
+  REQUIRE_FALSE( handler.pop_signal<SIGUSR2>() );
+
+  REQUIRE      ( kill(getpid(), SIGUSR2) == 0 );
+  SignalMask_t mask{};
+  REQUIRE      ( eventually([&] { return handler.test_all_signals(mask); }, std::chrono::seconds(2)) );
+  REQUIRE      ( mask.OS_sigs == signal_bitmask(SIGUSR2) );
+  REQUIRE      ( handler.pop_all_signals(mask) );
+  REQUIRE_FALSE( handler.test_all_signals(mask) );
+}
+
+TEST_CASE("SignalHandler: Subscribers sharing one installation", "[unit] [SignalHandler]")
+{
+  REQUIRE_THROWS_AS( SignalHandler({0}), std::invalid_argument );
+
+  StaticSignalHandler<SIGUSR1> first;
+  {
+    SignalHandler second({SIGUSR1, SIGUSR2});
+    int efd = second.event_fd();
+    REQUIRE      ( efd >= 0 );
+    REQUIRE      ( second.event_fd() == efd );
+
+    REQUIRE      ( kill(getpid(), SIGUSR1) == 0 );
+    REQUIRE      ( eventually([&] { return first.test_signal<SIGUSR1>(); }, std::chrono::seconds(2)) );
+    REQUIRE      ( eventually([&] { return second.test_signal(SIGUSR1); }, std::chrono::seconds(2)) );
+
+    // Each subscriber has its own pending states
+    REQUIRE      ( first.pop_signal<SIGUSR1>() );
+    REQUIRE      ( second.test_signal(SIGUSR1) );
+
+    REQUIRE      ( kill(getpid(), SIGUSR2) == 0 );
+    REQUIRE      ( eventually([&] { return second.test_signal(SIGUSR2); }, std::chrono::seconds(2)) );
+    REQUIRE_FALSE( first.test_signal(SIGUSR2) );
+
+    uint64_t count = 0;
+    REQUIRE      ( read(efd, &count, sizeof(count)) == sizeof(count) );
+    REQUIRE      ( count == 2U );
+  }
+
+  // The first subscriber keeps receiving once the second is gone
+  REQUIRE      ( kill(getpid(), SIGUSR1) == 0 );
+  REQUIRE      ( eventually([&] { return first.pop_signal(SIGUSR1); }, std::chrono::seconds(2)) );
+}
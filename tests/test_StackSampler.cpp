@@ -0,0 +1,65 @@
+#include <catch2/catch_test_macros.hpp>
+#include <ThreadManager.hpp>
+#include <StackSampler.hpp>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace
+{
+  // Keeps the calling thread on the CPU for `duration`
+  [[gnu::noinline]] uint64_t burn(std::chrono::milliseconds duration)
+  {
+    volatile uint64_t sink = 0;
+    auto deadline = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+      for (int i = 0; i < 1000; i++)
+      {
+        sink = sink + static_cast<uint64_t>(i);
+      }
+    }
+    return sink;
+  }
+}
+
+TEST_CASE("StackSampler: Samples managed threads into folded stacks", "[unit] [StackSampler]")
+{
+  StackSampler sampler(std::chrono::milliseconds(1));
+  REQUIRE_THROWS_AS( StackSampler(), std::logic_error );
+
+  ThreadManager tm;
+  tm.set_sampler(&sampler);
+  for (int i = 0; i < 2; i++)
+  {
+    tm.spawn_thread([] (std::stop_token, std::stop_token) {
+      burn(std::chrono::milliseconds(100));
+    });
+  }
+  tm.join();
+  tm.set_sampler(nullptr);
+
+  REQUIRE( sampler.samples() > 0 );
+
+  std::ostringstream folded;
+  sampler.write_folded(folded);
+  std::string line;
+  std::istringstream lines(folded.str());
+  uint64_t counted = 0;
+  while (std::getline(lines, line))
+  {
+    size_t space = line.rfind(' ');
+    REQUIRE( space != std::string::npos );
+    counted += std::stoull(line.substr(space + 1));
+  }
+  REQUIRE( counted == sampler.samples() );
+
+  // Unsampled work leaves the buffers untouched
+  uint64_t before = sampler.samples();
+  tm.spawn_thread([] (std::stop_token, std::stop_token) {
+    burn(std::chrono::milliseconds(20));
+  });
+  tm.join();
+  REQUIRE( sampler.samples() == before );
+}
@@ -0,0 +1,85 @@
+#include <catch2/catch_test_macros.hpp>
+#include <StartBarrier.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+TEST_CASE("StartBarrier: Releases threads once all arrived", "[unit] [StartBarrier]")
+{
+  static constexpr uint32_t MEMBERS = 8U;
+  StartBarrier barrier(MEMBERS);
+  std::atomic<uint32_t> passed{0};
+
+  std::vector<std::thread> members;
+  for (uint32_t i = 0; i + 1 < MEMBERS; i++)
+  {
+    members.emplace_back([&] {
+      if (barrier.arrive_and_wait())
+      {
+        passed++;
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  REQUIRE      ( passed.load() == 0U );
+  REQUIRE_FALSE( barrier.released() );
+  REQUIRE_THROWS_AS( barrier.report(), std::logic_error );
+
+  REQUIRE( barrier.arrive_and_wait() );
+  for (auto& member : members)
+  {
+    member.join();
+  }
+  REQUIRE( passed.load() == MEMBERS - 1 );
+  REQUIRE( barrier.released() );
+
+  GangSkew_t skew = barrier.report();
+  // The first members waited for the last one
+  REQUIRE( skew.arrival_spread_ns >= 20'000'000U );
+  REQUIRE( skew.release_skew_ns <= skew.release_latency_ns );
+  REQUIRE_THROWS_AS( barrier.arrive_and_wait(), std::length_error );
+  REQUIRE_THROWS_AS( StartBarrier(0), std::invalid_argument );
+}
+
+TEST_CASE("StartBarrier: Cancel releases waiting members", "[unit] [StartBarrier]")
+{
+  StartBarrier barrier(3);
+  std::thread member([&] { REQUIRE_FALSE( barrier.arrive_and_wait() ); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  barrier.cancel();
+  member.join();
+  REQUIRE_FALSE( barrier.arrive_and_wait() );
+  REQUIRE_FALSE( barrier.released() );
+}
+
+TEST_CASE("StartBarrier: Releases forked processes", "[unit] [StartBarrier]")
+{
+  static constexpr uint32_t CHILDREN = 3U;
+  StartBarrier barrier(CHILDREN + 1, BARRIER_SCOPE_ENM::processes);
+
+  std::vector<pid_t> children;
+  for (uint32_t i = 0; i < CHILDREN; i++)
+  {
+    pid_t pid = fork();
+    REQUIRE( pid != -1 );
+    if (pid == 0)
+    {
+      _exit(barrier.arrive_and_wait() ? 0 : 1);
+    }
+    children.push_back(pid);
+  }
+
+  REQUIRE( barrier.arrive_and_wait() );
+  for (pid_t pid : children)
+  {
+    int status = 0;
+    REQUIRE( waitpid(pid, &status, 0) == pid );
+    REQUIRE( WIFEXITED(status) );
+    REQUIRE( WEXITSTATUS(status) == 0 );
+  }
+  REQUIRE( barrier.released() );
+  REQUIRE_NOTHROW( barrier.report() );
+}
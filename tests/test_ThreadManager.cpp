@@ -1,9 +1,20 @@
 #include <catch2/catch_test_macros.hpp>
 #include <ThreadManager.hpp>
+#include "TestHelpers.hpp"
 #include <set>
+#include <stdexcept>
 #include <thread>
 #include <chrono>
 #include <unordered_set>
+#include <atomic>
+#include <vector>
+#include <poll.h>
+
+namespace
+{
+  // Manager whose stats() reports the events the tests check
+  using CountingManager = BasicThreadManager<HashRegistry, InternalLock, PerCpuCounter, CountingStats>;
+}
 
 TEST_CASE("ThreadManager: Zero threads construction & destruction", "[unit] [ThreadManager]")
 {
@@ -131,4 +142,605 @@ TEST_CASE("ThreadManager: Validating status API functions", "[unit] [ThreadManag
   
   REQUIRE      ( tm.alive_threads() == 0 );
   REQUIRE_FALSE( tm.any_running() );
-}
\ No newline at end of file
+}
+TEST_CASE("ThreadManager: Workers taking a CancellationToken as global token", "[unit] [ThreadManager]")
+{
+  constexpr unsigned LAUNCH_LIM = 10U;
+
+  ThreadManager tm;
+  std::atomic<unsigned> observed{0};
+
+  for (unsigned i = 0; i < LAUNCH_LIM; i++)
+  {
+    tm.spawn_thread([&observed](std::stop_token, CancellationToken gct){
+      while (!gct.stop_requested())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      observed.fetch_add(1);
+    });
+  }
+  tm.spawn_thread([](std::stop_token, std::stop_token gst){
+    while (!gst.stop_requested())
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  });
+
+  REQUIRE      ( tm.global_token().stop_possible() );
+  REQUIRE      ( tm.request_stop_all() );
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE      ( observed.load() == LAUNCH_LIM );
+  REQUIRE      ( tm.global_token().stop_requested() );
+}
+
+TEST_CASE("ThreadManager: Workers taking CancellationTokens as both tokens", "[unit] [ThreadManager]")
+{
+  ThreadManager tm;
+  tm.set_thread_cache(2U);
+  tm.reserve(2U);
+
+  auto until_stopped = [](CancellationToken lct, CancellationToken gct){
+    while (!lct.stop_requested() && !gct.stop_requested())
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  };
+  std::thread::id stopped = tm.spawn_thread(until_stopped);
+  std::thread::id running = tm.spawn_thread(until_stopped);
+
+  REQUIRE      ( tm.request_stop(stopped) );
+  REQUIRE      ( tm.stop_requested(stopped) );
+  REQUIRE_FALSE( tm.stop_requested(running) );
+  REQUIRE      ( eventually([&tm] { return tm.alive_threads() == 1U; }) );
+  REQUIRE      ( tm.request_stop_all() );
+  REQUIRE_NOTHROW( tm.join() );
+
+  // The stopped sources were re-armed for the next spawns
+  std::atomic<int> stopped_at_start{0};
+  for (int i = 0; i < 2; i++)
+  {
+    tm.spawn_thread([&stopped_at_start](CancellationToken lct, CancellationToken){
+      stopped_at_start.fetch_add(lct.stop_requested() ? 1 : 0);
+    });
+  }
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE      ( stopped_at_start.load() == 0 );
+
+  // The manager stops unjoined work on its own threads on destruction
+  {
+    ThreadManager own;
+    own.spawn_thread([](CancellationToken lct, CancellationToken){
+      while (!lct.stop_requested())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  }
+}
+
+TEST_CASE("ThreadManager: Reusing parked threads through the thread cache", "[unit] [ThreadManager]")
+{
+  ThreadManager tm;
+  tm.set_thread_cache(4U, std::chrono::milliseconds(100));
+
+  std::atomic<bool> release{false};
+  std::thread::id first = tm.spawn_thread([&release](std::stop_token lst, std::stop_token){
+    while (!release.load() && !lst.stop_requested())
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  REQUIRE      ( tm.alive_threads() == 1U );
+  REQUIRE      ( tm.request_stop(first) );
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE      ( tm.total_threads() == 0 );
+  REQUIRE      ( tm.alive_threads() == 0 );
+
+  // Parking happens right after the work returns
+  for (int i = 0; i < 100 && tm.cached_threads() == 0; i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  REQUIRE      ( tm.cached_threads() == 1U );
+
+  std::atomic<bool> stopped_at_start{true};
+  std::thread::id second = tm.spawn_thread([&](std::stop_token lst, std::stop_token){
+    stopped_at_start = lst.stop_requested();
+  });
+
+  REQUIRE      ( second == first );
+  REQUIRE_FALSE( tm.stop_requested(second) );
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE_FALSE( stopped_at_start.load() );
+
+  // Parked threads exit after the idle timeout
+  std::this_thread::sleep_for(std::chrono::milliseconds(400));
+  REQUIRE      ( tm.cached_threads() == 0 );
+
+  for (int i = 0; i < 20; i++)
+  {
+    tm.spawn_thread([](std::stop_token, std::stop_token){ });
+  }
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE      ( tm.alive_threads() == 0 );
+}
+
+TEST_CASE("ThreadManager: Cached threads keep one entry per unjoined spawn", "[unit] [ThreadManager]")
+{
+  static constexpr unsigned LAUNCH_LIM = 8U;
+  ThreadManager tm;
+  tm.set_thread_cache(LAUNCH_LIM, std::chrono::seconds(10));
+
+  std::set<std::thread::id> ids;
+  for (unsigned i = 0; i < LAUNCH_LIM; i++)
+  {
+    ids.insert(tm.spawn_thread([](std::stop_token, std::stop_token){ }));
+    // Finished work still holds its thread until joined
+    REQUIRE    ( eventually([&] { return tm.alive_threads() == 0; }) );
+  }
+  REQUIRE      ( ids.size() == LAUNCH_LIM );
+  REQUIRE      ( tm.total_threads() == LAUNCH_LIM );
+  REQUIRE      ( tm.cached_threads() == 0 );
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE      ( tm.cached_threads() == LAUNCH_LIM );
+
+  // A stop request reaches exactly the spawn it names
+  std::atomic<bool> release{false};
+  auto wait = [&release](std::stop_token lst, std::stop_token){
+    while (!release.load() && !lst.stop_requested())
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  };
+  std::thread::id first = tm.spawn_thread(wait);
+  std::thread::id second = tm.spawn_thread(wait);
+  REQUIRE      ( first != second );
+  REQUIRE      ( tm.request_stop(first) );
+  REQUIRE      ( eventually([&] { return tm.alive_threads() == 1U; }) );
+  REQUIRE_FALSE( tm.stop_requested(second) );
+  release = true;
+  REQUIRE_NOTHROW( tm.join() );
+  REQUIRE      ( tm.total_threads() == 0 );
+
+  // Held threads still time out, and are recycled once joined
+  BasicThreadManager<SlotArrayRegistry, SpinLock> short_lived;
+  short_lived.set_thread_cache(2U, std::chrono::milliseconds(10));
+  short_lived.spawn_thread([](std::stop_token, std::stop_token){ });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  REQUIRE_NOTHROW( short_lived.join() );
+  REQUIRE      ( short_lived.cached_threads() == 0 );
+  std::atomic<unsigned> ran{0};
+  for (int i = 0; i < 4; i++)
+  {
+    short_lived.spawn_thread([&ran](std::stop_token, std::stop_token){ ran++; });
+  }
+  // Left unjoined for the destructor
+  REQUIRE      ( eventually([&] { return ran.load() == 4U; }) );
+}
+
+TEST_CASE("ThreadManager: Policy combinations", "[unit] [ThreadManager]")
+{
+  static constexpr unsigned LAUNCH_LIM = 8U;
+
+  auto exercise = [] (auto& tm) {
+    std::atomic<unsigned> ran{0};
+    std::thread::id tid;
+    for (unsigned i = 0; i < LAUNCH_LIM; i++)
+    {
+      tid = tm.spawn_thread([&ran](std::stop_token lst, std::stop_token gst){
+        while (!lst.stop_requested() && !gst.stop_requested())
+        {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ran++;
+      });
+    }
+    REQUIRE      ( tm.total_threads() == LAUNCH_LIM );
+    REQUIRE      ( tm.request_stop(tid) );
+    REQUIRE      ( tm.stop_requested(tid) );
+    REQUIRE_THROWS_AS( tm.stop_requested(std::this_thread::get_id()), std::invalid_argument );
+    REQUIRE      ( tm.request_stop_all() );
+    REQUIRE_NOTHROW( tm.join() );
+    REQUIRE      ( ran.load() == LAUNCH_LIM );
+    REQUIRE      ( tm.total_threads() == 0 );
+    REQUIRE      ( tm.alive_threads() == 0 );
+  };
+
+  SECTION("Slot array registry, spinlock, atomic counter, stats")
+  {
+    BasicThreadManager<SlotArrayRegistry, SpinLock, AtomicCounter, CountingStats> tm;
+    tm.reserve(LAUNCH_LIM);
+    REQUIRE      ( tm.capacity() >= LAUNCH_LIM );
+    exercise(tm);
+
+    ThreadManagerStats_t stats = tm.stats();
+    REQUIRE      ( stats.spawned == LAUNCH_LIM );
+    REQUIRE      ( stats.joined == LAUNCH_LIM );
+    REQUIRE      ( stats.local_stop_requests == 1U );
+    REQUIRE      ( stats.global_stop_requests == 1U );
+  }
+
+  SECTION("Fixed registry without locking")
+  {
+    BasicThreadManager<FixedRegistry<LAUNCH_LIM>, NullLock> tm;
+    REQUIRE      ( tm.capacity() == LAUNCH_LIM );
+    REQUIRE_THROWS_AS( tm.reserve(LAUNCH_LIM + 1), std::length_error );
+    exercise(tm);
+    REQUIRE      ( tm.stats().spawned == 0 );
+  }
+
+  SECTION("Fixed registry refuses threads beyond its capacity")
+  {
+    BasicThreadManager<FixedRegistry<1>> tm;
+    std::atomic<unsigned> ran{0};
+    auto work = [&ran](std::stop_token lst, std::stop_token){
+      ran++;
+      while (!lst.stop_requested())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    };
+    std::thread::id tid = tm.spawn_thread(work);
+
+    // Refused up front, without running or waiting for the work
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE_THROWS_AS( tm.spawn_thread(work), std::length_error );
+    REQUIRE      ( std::chrono::steady_clock::now() - start < std::chrono::seconds(1) );
+    REQUIRE      ( tm.total_threads() == 1U );
+    REQUIRE      ( tm.request_stop(tid) );
+    REQUIRE_NOTHROW( tm.join() );
+    REQUIRE      ( ran.load() == 1U );
+    REQUIRE      ( tm.alive_threads() == 0 );
+
+    // Likewise through the thread cache
+    tm.set_thread_cache(2U);
+    tid = tm.spawn_thread(work);
+    REQUIRE_THROWS_AS( tm.spawn_thread(work), std::length_error );
+    REQUIRE      ( tm.request_stop(tid) );
+    REQUIRE_NOTHROW( tm.join() );
+    REQUIRE      ( ran.load() == 2U );
+  }
+}
+
+TEST_CASE("ThreadManager: Reserving with the thread cache prestarts threads", "[unit] [ThreadManager]")
+{
+  constexpr unsigned CAPACITY = 4U;
+
+  ThreadManager tm;
+  tm.set_thread_cache(CAPACITY, std::chrono::seconds(10));
+  tm.reserve(CAPACITY);
+  REQUIRE      ( tm.cached_threads() == CAPACITY );
+
+  std::set<std::thread::id> ids;
+  for (unsigned round = 0; round < 3; round++)
+  {
+    for (unsigned i = 0; i < CAPACITY; i++)
+    {
+      ids.insert(tm.spawn_thread([](std::stop_token, CancellationToken){ }));
+    }
+    REQUIRE_NOTHROW( tm.join() );
+    // Workers are parked again by the time join() returns
+    REQUIRE      ( tm.cached_threads() == CAPACITY );
+  }
+  // Every spawn ran on one of the prestarted threads
+  REQUIRE      ( ids.size() <= CAPACITY );
+
+  STATIC_REQUIRE( UniqueTask::fits_inline<void (*)()> );
+}
+
+TEST_CASE("ThreadManager: Watchdog flags and stops stalled work", "[unit] [ThreadManager]")
+{
+  SECTION("Stopping stalled work")
+  {
+    CountingManager tm;
+    tm.set_watchdog(std::chrono::milliseconds(100), WATCHDOG_ACTION_ENM::stop);
+    REQUIRE_THROWS_AS( tm.set_watchdog(std::chrono::milliseconds(40)), std::logic_error );
+
+    std::atomic<bool> done{false};
+    std::atomic<bool> silent_stopped{false};
+    std::thread::id beating = tm.spawn_thread([&done](std::stop_token lst, std::stop_token){
+      while (!lst.stop_requested() && !done.load())
+      {
+        heartbeat();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+    });
+    tm.spawn_thread([&silent_stopped](std::stop_token lst, std::stop_token){
+      while (!lst.stop_requested())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+      silent_stopped = true;
+    });
+
+    REQUIRE      ( eventually([&] { return silent_stopped.load(); }) );
+    REQUIRE_FALSE( tm.stop_requested(beating) );
+    done = true;
+    REQUIRE_NOTHROW( tm.join() );
+    REQUIRE      ( tm.stats().stalls == 1U );
+  }
+
+  SECTION("Joining stalled work")
+  {
+    CountingManager tm;
+    tm.set_watchdog(std::chrono::milliseconds(50), WATCHDOG_ACTION_ENM::stop);
+    tm.spawn_thread([](std::stop_token lst, std::stop_token){
+      while (!lst.stop_requested())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+    });
+    tm.spawn_thread([](CancellationToken lct, CancellationToken){
+      while (!lct.stop_requested())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+    });
+
+    // join() holds the registry while the watchdog stops both
+    REQUIRE_NOTHROW( tm.join() );
+    REQUIRE      ( tm.stats().stalls == 2U );
+  }
+
+  SECTION("Flagging stalled work")
+  {
+    CountingManager tm;
+    tm.set_watchdog(std::chrono::milliseconds(20));
+    std::atomic<bool> release{false};
+    std::thread::id tid = tm.spawn_thread([&release](std::stop_token, std::stop_token){
+      while (!release.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+    });
+
+    REQUIRE      ( eventually([&] { return tm.stalled_threads() == 1U; }) );
+    REQUIRE_FALSE( tm.stop_requested(tid) );
+    release = true;
+    REQUIRE_NOTHROW( tm.join() );
+    REQUIRE      ( eventually([&] { return tm.stalled_threads() == 0U; }) );
+    REQUIRE      ( tm.stats().stalls == 1U );
+  }
+}
+
+TEST_CASE("ThreadManager: Supervised workers restart after exceptions", "[unit] [ThreadManager]")
+{
+  RestartPolicy_t policy;
+  policy.max_restarts = 3;
+  policy.initial_backoff = std::chrono::milliseconds(1);
+
+  SECTION("Restarting within the intensity")
+  {
+    CountingManager tm;
+    std::atomic<int> attempts{0};
+    tm.spawn_supervised(policy, [&attempts](std::stop_token, CancellationToken, int fail_times){
+      if (attempts.fetch_add(1) < fail_times)
+      {
+        throw std::runtime_error("transient");
+      }
+    }, 2);
+    REQUIRE_NOTHROW( tm.join() );
+    REQUIRE      ( attempts.load() == 3 );
+    REQUIRE      ( tm.stats().restarts == 2U );
+    REQUIRE      ( tm.stats().escalations == 0U );
+  }
+
+  SECTION("Without statistics nothing is counted")
+  {
+    ThreadManager tm;
+    policy.escalation = ESCALATION_ENM::give_up;
+    tm.spawn_supervised(policy, [](std::stop_token, CancellationToken){
+      throw std::runtime_error("persistent");
+    });
+    REQUIRE_NOTHROW( tm.join() );
+    REQUIRE      ( tm.stats().restarts == 0U );
+    REQUIRE      ( tm.stats().escalations == 0U );
+  }
+
+  SECTION("Giving up keeps the siblings running")
+  {
+    CountingManager tm;
+    std::atomic<bool> sibling_stopped{false};
+    tm.spawn_thread([&sibling_stopped](std::stop_token lst, std::stop_token gst){
+      while (!lst.stop_requested() && !gst.stop_requested())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      sibling_stopped = true;
+    });
+
+    std::atomic<int> attempts{0};
+    policy.escalation = ESCALATION_ENM::give_up;
+    tm.spawn_supervised(policy, [&attempts](std::stop_token, std::stop_token){
+      attempts++;
+      throw std::runtime_error("persistent");
+    });
+
+    while (tm.stats().escalations == 0U)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE      ( attempts.load() == 4 );
+    REQUIRE_FALSE( sibling_stopped.load() );
+    REQUIRE      ( tm.request_stop_all() );
+    REQUIRE_NOTHROW( tm.join() );
+  }
+
+  SECTION("Escalating to a global stop")
+  {
+    CountingManager tm;
+    policy.max_restarts = 0;
+    policy.escalation = ESCALATION_ENM::stop_all;
+    tm.spawn_supervised(policy, [](std::stop_token, CancellationToken){
+      throw std::runtime_error("fatal");
+    });
+    REQUIRE_NOTHROW( tm.join() );
+    REQUIRE      ( tm.stop_requested_all() );
+    REQUIRE      ( tm.stats().escalations == 1U );
+  }
+
+  SECTION("A stop request ends the backoff")
+  {
+    CountingManager tm;
+    policy.initial_backoff = std::chrono::seconds(30);
+    std::atomic<int> attempts{0};
+    std::thread::id tid = tm.spawn_supervised(policy, [&attempts](std::stop_token, CancellationToken){
+      attempts++;
+      throw std::runtime_error("transient");
+    });
+    while (attempts.load() == 0)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE      ( tm.request_stop(tid) );
+    REQUIRE_NOTHROW( tm.join() );
+    REQUIRE      ( std::chrono::steady_clock::now() - start < std::chrono::seconds(10) );
+    REQUIRE      ( attempts.load() == 1 );
+    REQUIRE      ( tm.stats().restarts == 0U );
+  }
+}
+
+TEST_CASE("ThreadManager: Reaper removes finished threads", "[unit] [ThreadManager]")
+{
+  static constexpr unsigned LAUNCH_LIM = 32U;
+
+  SECTION("Own threads")
+  {
+    BasicThreadManager<HashRegistry, std::mutex, PerCpuCounter, CountingStats> tm;
+    tm.enable_reaper();
+    REQUIRE_THROWS_AS( tm.enable_reaper(), std::logic_error );
+
+    for (unsigned i = 0; i < LAUNCH_LIM; i++)
+    {
+      tm.spawn_thread([](std::stop_token, CancellationToken){ });
+    }
+    REQUIRE      ( eventually([&] { return tm.stats().reaped == LAUNCH_LIM; }) );
+    REQUIRE      ( tm.total_threads() == 0 );
+    REQUIRE      ( tm.stats().joined == LAUNCH_LIM );
+    REQUIRE_NOTHROW( tm.join() );
+  }
+
+  SECTION("Cached threads keep a bounded registry")
+  {
+    // Would overflow without the reaper
+    BasicThreadManager<FixedRegistry<2>, InternalLock, PerCpuCounter, CountingStats> tm;
+    tm.set_thread_cache(2, std::chrono::seconds(10));
+    tm.enable_reaper();
+
+    std::atomic<bool> release{false};
+    std::thread::id running = tm.spawn_thread([&release](std::stop_token, CancellationToken){
+      while (!release.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+    for (unsigned i = 0; i < LAUNCH_LIM; i++)
+    {
+      REQUIRE_NOTHROW( tm.spawn_thread([](std::stop_token, CancellationToken){ }) );
+      REQUIRE    ( eventually([&] { return tm.total_threads() == 1; }) );
+    }
+    // Unfinished work keeps its entry
+    REQUIRE_FALSE( tm.stop_requested(running) );
+    release = true;
+    REQUIRE      ( eventually([&] { return tm.stats().reaped == LAUNCH_LIM + 1; }) );
+    REQUIRE      ( tm.total_threads() == 0 );
+    REQUIRE_NOTHROW( tm.join() );
+  }
+}
+
+TEST_CASE("ThreadManager: Gang spawn starts members together", "[unit] [ThreadManager]")
+{
+  static constexpr uint32_t MEMBERS = 6U;
+  ThreadManager tm;
+  StartBarrier barrier(MEMBERS);
+  std::atomic<uint32_t> started{0};
+
+  auto tids = tm.spawn_gang(barrier, [](std::stop_token, CancellationToken, std::atomic<uint32_t>* count){
+    count->fetch_add(1);
+  }, &started);
+  REQUIRE( tids.size() == MEMBERS );
+  REQUIRE( std::unordered_set<std::thread::id>(tids.begin(), tids.end()).size() == MEMBERS );
+  tm.join();
+
+  REQUIRE( started.load() == MEMBERS );
+  REQUIRE( barrier.released() );
+  GangSkew_t skew = barrier.report();
+  REQUIRE( skew.release_skew_ns <= skew.release_latency_ns );
+}
+
+TEST_CASE("ThreadManager: Completions through an eventfd", "[unit] [ThreadManager]")
+{
+  static constexpr unsigned LAUNCH_LIM = 8U;
+  ThreadManager tm;
+  int fd = tm.completion_fd();
+  REQUIRE( fd >= 0 );
+  REQUIRE( tm.completion_fd() == fd );
+
+  std::unordered_set<std::thread::id> spawned;
+  for (unsigned i = 0; i < LAUNCH_LIM; i++)
+  {
+    spawned.insert(tm.spawn_thread([](std::stop_token, CancellationToken){ }));
+  }
+
+  std::vector<std::thread::id> finished;
+  while (finished.size() < LAUNCH_LIM)
+  {
+    pollfd pfd{fd, POLLIN, 0};
+    REQUIRE( poll(&pfd, 1, 5000) == 1 );
+    // Batches never exceed the requested size
+    size_t before = finished.size();
+    REQUIRE( tm.drain_completions(finished, 3) <= 3U );
+    REQUIRE( finished.size() - before <= 3U );
+  }
+  REQUIRE( std::unordered_set<std::thread::id>(finished.begin(), finished.end()) == spawned );
+
+  // Drained: no longer readable
+  pollfd pfd{fd, POLLIN, 0};
+  REQUIRE( poll(&pfd, 1, 0) == 0 );
+  REQUIRE( tm.drain_completions(finished) == 0U );
+  tm.join();
+}
+
+TEST_CASE("ThreadManager: Batched spawn", "[unit] [ThreadManager]")
+{
+  static constexpr size_t LAUNCH_LIM = 64U;
+
+  SECTION("Ids and generated arguments")
+  {
+    BasicThreadManager<HashRegistry, std::mutex, PerCpuCounter, CountingStats> tm;
+    std::vector<std::atomic<size_t>> seen(LAUNCH_LIM);
+    std::vector<std::thread::id> ids(LAUNCH_LIM);
+
+    tm.spawn_many(ids, [](std::stop_token, CancellationToken, std::atomic<size_t>* slot, size_t value){
+      slot->store(value);
+    }, [&seen] (size_t i) {
+      return std::make_tuple(&seen[i], i + 1);
+    });
+    REQUIRE( std::unordered_set<std::thread::id>(ids.begin(), ids.end()).size() == LAUNCH_LIM );
+    REQUIRE( tm.total_threads() == LAUNCH_LIM );
+    tm.join();
+
+    for (size_t i = 0; i < LAUNCH_LIM; i++)
+    {
+      REQUIRE( seen[i].load() == i + 1 );
+    }
+    REQUIRE( tm.stats().spawned == LAUNCH_LIM );
+    REQUIRE( tm.alive_threads() == 0 );
+
+    REQUIRE_NOTHROW( tm.spawn_many(std::span<std::thread::id>(), [](std::stop_token, std::stop_token){ }) );
+  }
+
+  SECTION("A full registry fails the batch up front")
+  {
+    BasicThreadManager<FixedRegistry<4>> tm;
+    std::vector<std::thread::id> ids(8);
+    REQUIRE_THROWS_AS( tm.spawn_many(ids, [](std::stop_token, std::stop_token){ }), std::length_error );
+    REQUIRE( tm.total_threads() == 0 );
+    REQUIRE( tm.alive_threads() == 0 );
+    REQUIRE( ids[0] == std::thread::id() );
+  }
+}
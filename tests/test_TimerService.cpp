@@ -0,0 +1,150 @@
+#include <catch2/catch_test_macros.hpp>
+#include <TimerService.hpp>
+#include "TestHelpers.hpp"
+#include <atomic>
+#include <chrono>
+#include <stop_token>
+#include <thread>
+
+TEST_CASE("TimerService: One-shot timers run once, in order", "[unit] [TimerService]")
+{
+  ThreadManager tm;
+  tm.set_thread_cache(4);
+  std::atomic<int> order{0};
+  std::atomic<int> first{0}, second{0};
+  auto start = std::chrono::steady_clock::now();
+  std::atomic<int64_t> elapsed_ms{0};
+  {
+    TimerService timers(tm);
+    // Lands on a higher level of the wheel, then moves down
+    timers.schedule_after(std::chrono::milliseconds(150), [&](std::stop_token, CancellationToken){
+      second = ++order;
+      elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start
+      ).count();
+    });
+    timers.schedule_after(std::chrono::milliseconds(10), [&](std::stop_token, CancellationToken){
+      first = ++order;
+    });
+    REQUIRE( timers.pending() == 2U );
+    REQUIRE( eventually([&] { return order.load() == 2; }) );
+    REQUIRE( timers.pending() == 0U );
+  }
+  REQUIRE( first.load() == 1 );
+  REQUIRE( second.load() == 2 );
+  REQUIRE( elapsed_ms.load() >= 150 );
+  tm.join();
+}
+
+TEST_CASE("TimerService: Periodic timers and cancellation", "[unit] [TimerService]")
+{
+  ThreadManager tm;
+  tm.set_thread_cache(4);
+  TimerService timers(tm);
+
+  SECTION("cancel()")
+  {
+    std::atomic<int> runs{0};
+    TimerId_t id = timers.schedule_every(std::chrono::milliseconds(5), [&](std::stop_token, CancellationToken){
+      runs++;
+    });
+    REQUIRE( eventually([&] { return runs.load() >= 3; }) );
+    REQUIRE      ( timers.cancel(id) );
+    REQUIRE_FALSE( timers.cancel(id) );
+    // A run may have been in flight
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    int settled = runs.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    REQUIRE( runs.load() == settled );
+  }
+
+  SECTION("Stop token")
+  {
+    std::stop_source cancel;
+    std::atomic<int> runs{0};
+    timers.schedule_after(std::chrono::milliseconds(20), [&](std::stop_token, CancellationToken){
+      runs++;
+    }, cancel.get_token());
+    cancel.request_stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE( runs.load() == 0 );
+    REQUIRE( timers.pending() == 0U );
+  }
+
+  SECTION("Overlapping runs are skipped")
+  {
+    std::atomic<int> runs{0};
+    std::atomic<bool> release{false};
+    timers.schedule_every(std::chrono::milliseconds(2), [&](std::stop_token, CancellationToken){
+      runs++;
+      while (!release.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+    REQUIRE( eventually([&] { return timers.skipped() >= 5U; }) );
+    REQUIRE( runs.load() == 1 );
+    release = true;
+  }
+
+  timers.shutdown();
+  REQUIRE( timers.pending() == 0U );
+  REQUIRE_THROWS_AS( timers.schedule_after(std::chrono::milliseconds(1), [](std::stop_token, CancellationToken){ }),
+                     std::logic_error );
+  tm.join();
+}
+
+TEST_CASE("TimerService: A global stop stops the service", "[unit] [TimerService]")
+{
+  ThreadManager tm;
+  TimerService timers(tm);
+  std::atomic<int> runs{0};
+  timers.schedule_after(std::chrono::milliseconds(50), [&](std::stop_token, CancellationToken){
+    runs++;
+  });
+  tm.request_stop_all();
+  REQUIRE_THROWS_AS( timers.schedule_after(std::chrono::milliseconds(1), [](std::stop_token, CancellationToken){ }),
+                     std::logic_error );
+  timers.shutdown();
+  std::this_thread::sleep_for(std::chrono::milliseconds(80));
+  REQUIRE( runs.load() == 0 );
+  tm.join();
+}
+
+TEST_CASE("TimerService: Runs leave no registry entries behind", "[unit] [TimerService]")
+{
+  ThreadManager tm;
+  TimerService timers(tm);
+  REQUIRE( tm.reaper_enabled() );
+
+  std::atomic<int> runs{0};
+  timers.schedule_every(std::chrono::milliseconds(1), [&](std::stop_token, CancellationToken){
+    runs++;
+  });
+  REQUIRE( eventually([&] { return runs.load() >= 50; }) );
+  // At most a run or two in flight keep their entries
+  REQUIRE( eventually([&] { return tm.total_threads() <= 2U; }) );
+
+  // A second service leaves the running reaper alone
+  REQUIRE_NOTHROW( TimerService(tm) );
+  timers.shutdown();
+  tm.join();
+}
+
+TEST_CASE("TimerService: A join after a global stop does not wait for the service", "[unit] [TimerService]")
+{
+  BasicThreadManager<SlotArrayRegistry, SpinLock, AtomicCounter, CountingStats> tm;
+  BasicTimerService timers(tm);
+  std::atomic<int> runs{0};
+  timers.schedule_every(std::chrono::milliseconds(1), [&](std::stop_token, CancellationToken){
+    runs++;
+  });
+  REQUIRE( eventually([&] { return runs.load() >= 5; }) );
+
+  tm.request_stop_all();
+  REQUIRE_NOTHROW( tm.join() );
+  int settled = runs.load();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  REQUIRE( runs.load() == settled );
+  REQUIRE( tm.total_threads() == 0 );
+}